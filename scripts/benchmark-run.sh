@@ -0,0 +1,126 @@
+#!/bin/bash
+#
+# MIT License
+#
+# Copyright(c) 2011-2020 The Maintainers of Nanvix
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+
+#
+# Runs all benchmarks of a target and compares results against a baseline.
+#
+# Usage: benchmark-run.sh <target> [baseline]
+#
+# Each img/<target>-*.img is built and run in turn, and the console output
+# of each run is saved in results/<target>/<timestamp>/. Records are then
+# collected into results.csv and compared against the baseline, which is
+# either the one given in the command line, the one checked in at
+# baseline/<target>.csv or the results of the previous run, in this order.
+# A run becomes the previous run only if all benchmarks completed and no
+# regression was found. The script exits with non-zero status otherwise.
+#
+# Environment:
+#   RUN_TIMEOUT Timeout for each benchmark, in seconds (default: 600).
+#   THRESHOLD   Minimum relative slowdown, in percent (default: 5).
+#   NOISE       Minimum slowdown, in multiples of the MAD (default: 3).
+#
+
+set -e
+
+TARGET=$1
+BASELINE=$2
+
+if [ -z "$TARGET" ]; then
+	echo "usage: $0 <target> [baseline]"
+	exit 1
+fi
+
+ROOTDIR=$(cd "$(dirname "$0")/.." && pwd)
+SCRIPTSDIR=$ROOTDIR/scripts
+RESULTSDIR=$ROOTDIR/results/$TARGET
+RUNDIR=$RESULTSDIR/$(date +%Y%m%d-%H%M%S)
+
+RUN_TIMEOUT=${RUN_TIMEOUT:-600}
+THRESHOLD=${THRESHOLD:-5}
+NOISE=${NOISE:-3}
+
+# Pick baseline.
+if [ -z "$BASELINE" ]; then
+	if [ -f "$ROOTDIR/baseline/$TARGET.csv" ]; then
+		BASELINE=$ROOTDIR/baseline/$TARGET.csv
+	elif [ -f "$RESULTSDIR/latest/results.csv" ]; then
+		BASELINE=$(readlink -f "$RESULTSDIR/latest/results.csv")
+	fi
+fi
+
+mkdir -p "$RUNDIR"
+
+NFAILED=0
+
+# Build and run benchmarks.
+for img in "$ROOTDIR"/img/"$TARGET"-*.img; do
+	name=$(basename "$img" .img)
+	name=${name#"$TARGET"-}
+
+	echo "[benchmark-run] $name"
+
+	if ! ${MAKE:-make} -C "$ROOTDIR" TARGET="$TARGET" IMGSRC="$img" all \
+		> "$RUNDIR/$name.build.txt" 2>&1
+	then
+		echo "[benchmark-run] $name failed to build (see $RUNDIR/$name.build.txt)"
+		NFAILED=$((NFAILED + 1))
+		continue
+	fi
+
+	if ! timeout "$RUN_TIMEOUT" ${MAKE:-make} -C "$ROOTDIR" TARGET="$TARGET" IMGSRC="$img" run \
+		> "$RUNDIR/$name.log" 2>&1
+	then
+		echo "[benchmark-run] $name failed or timed out (see $RUNDIR/$name.log)"
+		NFAILED=$((NFAILED + 1))
+	fi
+done
+
+# Collect results.
+python3 "$SCRIPTSDIR/collect.py" --format csv --output "$RUNDIR/results.csv" "$RUNDIR"/*.log
+
+echo "[benchmark-run] results saved in $RUNDIR/results.csv"
+
+# Compare against baseline.
+STATUS=0
+if [ -z "$BASELINE" ]; then
+	echo "[benchmark-run] no baseline found"
+else
+	echo "[benchmark-run] comparing against $BASELINE"
+	python3 "$SCRIPTSDIR/compare.py" --threshold "$THRESHOLD" --noise "$NOISE" \
+		"$BASELINE" "$RUNDIR/results.csv" || STATUS=$?
+fi
+
+if [ "$NFAILED" -gt 0 ]; then
+	echo "[benchmark-run] $NFAILED benchmark(s) failed to build, failed or timed out"
+	exit 1
+fi
+
+if [ "$STATUS" -ne 0 ]; then
+	exit "$STATUS"
+fi
+
+# Only a clean run becomes the next baseline.
+ln -sfn "$RUNDIR" "$RESULTSDIR/latest"
+echo "[benchmark-run] this run is the new baseline"
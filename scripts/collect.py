@@ -0,0 +1,314 @@
+#!/usr/bin/env python3
+#
+# MIT License
+#
+# Copyright(c) 2011-2020 The Maintainers of Nanvix
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+
+"""
+Collects benchmark records from console output.
+
+Benchmarks emit records (see src/include/benchmark/record.h) as lines of
+semicolon-separated fields:
+
+    [benchmarks];version;benchmark;variant;node;iteration;metric;value;unit
+
+Records may be preceded by arbitrary text (e.g. kernel log prefixes), and
+any line without a record is ignored. Parsed records are written as CSV
+or JSON.
+
+Benchmarks built with tracing enabled (see src/include/benchmark/trace.h)
+also emit traced events:
+
+    [trace];version;benchmark;variant;node;timestamp;phase;event;peer;size
+
+These are merged into a single timeline in the Chrome trace format, which
+can be opened in chrome://tracing or Perfetto. Clocks of all nodes are
+aligned on their first "sync" event, if every node of a run has one, and
+timestamps are converted to microseconds using the timer frequency that
+benchmarks report at calibration.
+
+Usage:
+
+    collect.py [--format csv|json|chrome] [--freq HZ] [--output FILE] [FILE...]
+"""
+
+import argparse
+import csv
+import json
+import sys
+
+#===============================================================================
+# Record Schema
+#===============================================================================
+
+# Tag that prefixes every record.
+RECORD_TAG = "[benchmarks];"
+
+# Supported versions of the record schema.
+RECORD_VERSIONS = (1,)
+
+# Fields of a record (version 1).
+RECORD_FIELDS = (
+    "version",
+    "benchmark",
+    "variant",
+    "node",
+    "iteration",
+    "metric",
+    "value",
+    "unit",
+)
+
+# Tag that prefixes every traced event.
+TRACE_TAG = "[trace];"
+
+# Supported versions of the trace schema.
+TRACE_VERSIONS = (1,)
+
+# Fields of a traced event (version 1).
+TRACE_FIELDS = (
+    "version",
+    "benchmark",
+    "variant",
+    "node",
+    "timestamp",
+    "phase",
+    "event",
+    "peer",
+    "size",
+)
+
+#===============================================================================
+# Parsing
+#===============================================================================
+
+def parse_variant(variant):
+    """Splits a variant into its name and parameters.
+
+    Variants are written as name[:key=value[,key=value...]].
+    """
+    name, _, params = variant.partition(":")
+    parsed = {}
+    for param in filter(None, params.split(",")):
+        key, _, value = param.partition("=")
+        parsed[key] = value
+    return name, parsed
+
+
+def parse_line(line):
+    """Parses a line of console output.
+
+    Returns a record (as a dictionary) or None if the line carries no
+    record. Raises ValueError on malformed records.
+    """
+    start = line.find(RECORD_TAG)
+    if start < 0:
+        return None
+
+    fields = line[start + len(RECORD_TAG):].rstrip("\r\n").split(";")
+    version = int(fields[0])
+    if version not in RECORD_VERSIONS:
+        raise ValueError("unsupported record version %d" % version)
+    if len(fields) != len(RECORD_FIELDS):
+        raise ValueError("expected %d fields, got %d" % (len(RECORD_FIELDS), len(fields)))
+
+    record = dict(zip(RECORD_FIELDS, fields))
+    record["version"] = version
+    record["node"] = int(record["node"])
+    record["iteration"] = int(record["iteration"])
+    record["value"] = int(record["value"])
+    return record
+
+
+def parse_trace_line(line):
+    """Parses a line of console output.
+
+    Returns a traced event (as a dictionary) or None if the line carries
+    no traced event. Raises ValueError on malformed events.
+    """
+    start = line.find(TRACE_TAG)
+    if start < 0:
+        return None
+
+    fields = line[start + len(TRACE_TAG):].rstrip("\r\n").split(";")
+    version = int(fields[0])
+    if version not in TRACE_VERSIONS:
+        raise ValueError("unsupported trace version %d" % version)
+    if len(fields) != len(TRACE_FIELDS):
+        raise ValueError("expected %d fields, got %d" % (len(TRACE_FIELDS), len(fields)))
+
+    event = dict(zip(TRACE_FIELDS, fields))
+    event["version"] = version
+    for field in ("node", "timestamp", "peer", "size"):
+        event[field] = int(event[field])
+    return event
+
+
+def parse(stream, source="-", parser=parse_line):
+    """Parses all records (or traced events) in a stream."""
+    records = []
+    for lineno, line in enumerate(stream, 1):
+        try:
+            record = parser(line)
+        except ValueError as err:
+            sys.stderr.write("%s:%d: skipping malformed line (%s)\n" % (source, lineno, err))
+            continue
+        if record is not None:
+            records.append(record)
+    return records
+
+
+def load(paths, parser=parse_line):
+    """Parses all records (or traced events) in a list of files ("-" is stdin)."""
+    records = []
+    for path in paths or ["-"]:
+        if path == "-":
+            records += parse(sys.stdin, parser=parser)
+        else:
+            with open(path, errors="replace") as stream:
+                records += parse(stream, path, parser)
+    return records
+
+#===============================================================================
+# Output
+#===============================================================================
+
+def write_csv(records, stream):
+    writer = csv.DictWriter(stream, fieldnames=RECORD_FIELDS)
+    writer.writeheader()
+    writer.writerows(records)
+
+
+def write_json(records, stream):
+    for record in records:
+        _, record["params"] = parse_variant(record["variant"])
+    json.dump(records, stream, indent=2)
+    stream.write("\n")
+
+
+def timer_frequency(records):
+    """Looks up the timer frequency (in Hz) reported at calibration."""
+    for record in records:
+        if (record["benchmark"], record["variant"], record["metric"]) == ("calibration", "timer", "frequency"):
+            return record["value"]
+    return None
+
+
+def clock_offsets(events):
+    """Computes the clock offset of every node in a run.
+
+    Nodes are aligned on their first "sync" event if every node has one.
+    Otherwise, raw timestamps are kept, relative to the earliest event.
+    Offsets are chosen so that no aligned timestamp is negative.
+    """
+    first = {}
+    sync = {}
+    for event in events:
+        node = event["node"]
+        first[node] = min(first.get(node, event["timestamp"]), event["timestamp"])
+        if event["event"] == "sync" and node not in sync:
+            sync[node] = event["timestamp"]
+
+    if not (sync and set(sync) == set(first)):
+        return {node: min(first.values()) for node in first}
+
+    # Keep aligned timestamps non-negative.
+    skew = max(sync[node] - first[node] for node in first)
+    return {node: sync[node] - skew for node in first}
+
+
+def write_chrome(events, stream, freq=None):
+    """Writes traced events in the Chrome trace format.
+
+    Each run (benchmark and variant) is drawn as a process, and each node
+    as a thread of it. Timestamps are in microseconds if the timer
+    frequency is known, or else in cycles.
+    """
+    runs = {}
+    for event in events:
+        runs.setdefault((event["benchmark"], event["variant"]), []).append(event)
+
+    if freq is None:
+        sys.stderr.write("timer frequency unknown, timestamps are in cycles\n")
+
+    trace = []
+    for pid, ((benchmark, variant), run) in enumerate(sorted(runs.items())):
+        trace.append({
+            "name": "process_name", "ph": "M", "pid": pid,
+            "args": {"name": "%s %s" % (benchmark, variant)},
+        })
+        offsets = clock_offsets(run)
+        for node in sorted(offsets):
+            trace.append({
+                "name": "thread_name", "ph": "M", "pid": pid, "tid": node,
+                "args": {"name": "node %d" % node},
+            })
+        for event in run:
+            ts = event["timestamp"] - offsets[event["node"]]
+            entry = {
+                "name": event["event"],
+                "ph": event["phase"],
+                "ts": ts*1e6/freq if freq else ts,
+                "pid": pid,
+                "tid": event["node"],
+                "args": {"peer": event["peer"], "size": event["size"]},
+            }
+            if event["phase"] == "i":
+                entry["s"] = "g" if event["event"] == "sync" else "t"
+            trace.append(entry)
+
+    json.dump({"traceEvents": trace, "displayTimeUnit": "ns"}, stream, indent=1)
+    stream.write("\n")
+
+#===============================================================================
+# Driver
+#===============================================================================
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description="Collects benchmark records from console output.")
+    parser.add_argument("files", nargs="*", help="console output files (default: stdin)")
+    parser.add_argument("--format", choices=("csv", "json", "chrome"), default="csv", help="output format")
+    parser.add_argument("--freq", type=int, help="timer frequency in Hz (default: as reported by benchmarks)")
+    parser.add_argument("--output", "-o", default="-", help="output file (default: stdout)")
+    args = parser.parse_args(argv)
+
+    if args.format == "chrome":
+        if "-" in (args.files or ["-"]):
+            parser.error("traces cannot be read from stdin")
+        freq = args.freq or timer_frequency(load(args.files))
+        records = load(args.files, parse_trace_line)
+        writer = lambda events, stream: write_chrome(events, stream, freq)
+    else:
+        records = load(args.files)
+        writer = write_csv if args.format == "csv" else write_json
+
+    if args.output == "-":
+        writer(records, sys.stdout)
+    else:
+        with open(args.output, "w", newline="") as stream:
+            writer(records, stream)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+#
+# MIT License
+#
+# Copyright(c) 2011-2020 The Maintainers of Nanvix
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+
+"""
+Compares benchmark results against a baseline.
+
+Both inputs are CSV files written by collect.py. Samples are grouped by
+(benchmark, variant, metric, unit), across nodes and iterations, and the
+medians of each group are compared. A change is flagged as significant
+only if it exceeds both a relative threshold and a multiple of the noise
+of the group, which is estimated with the median absolute deviation
+(MAD) of the samples.
+
+Usage:
+
+    compare.py [--threshold PCT] [--noise K] BASELINE RESULTS
+
+Exits with status 1 if any significant slowdown is found.
+"""
+
+import argparse
+import csv
+import statistics
+import sys
+
+#===============================================================================
+# Metrics
+#===============================================================================
+
+# Units in which lower values are better.
+LOWER_IS_BETTER = ("cycles", "cycles/KB", "cycles/MB", "cycles/Kname", "ns")
+
+# Units in which higher values are better.
+HIGHER_IS_BETTER = ("ops/s", "bytes/s", "keys/s", "flop/s", "records/s")
+
+#===============================================================================
+# Statistics
+#===============================================================================
+
+def load(path):
+    """Loads samples from a CSV file, grouped by metric."""
+    groups = {}
+    with open(path, newline="") as stream:
+        for row in csv.DictReader(stream):
+            key = (row["benchmark"], row["variant"], row["metric"], row["unit"])
+            groups.setdefault(key, []).append(int(row["value"]))
+    return groups
+
+
+def summarize(samples):
+    """Computes the median and the median absolute deviation of samples."""
+    median = statistics.median(samples)
+    mad = statistics.median([abs(x - median) for x in samples])
+    return median, mad
+
+
+def compare(baseline, results, threshold, noise):
+    """Compares results against a baseline.
+
+    Returns a list of (key, base median, new median, change, verdict).
+    Metrics of the baseline that are missing in the results, as when a
+    benchmark crashes, are reported as such. Calibration records describe
+    the measurement overhead, not the system, and are not compared.
+    """
+    report = []
+    for key in sorted(set(baseline) | set(results)):
+        if key[0] == "calibration":
+            continue
+        unit = key[3]
+        if key not in results:
+            report.append((key, summarize(baseline[key])[0], None, None, "MISSING"))
+            continue
+        if key not in baseline:
+            report.append((key, None, summarize(results[key])[0], None, "new"))
+            continue
+        if unit not in LOWER_IS_BETTER + HIGHER_IS_BETTER:
+            continue
+
+        base, base_mad = summarize(baseline[key])
+        new, new_mad = summarize(results[key])
+        delta = new - base
+        change = (delta / base) if base != 0 else 0.0
+
+        significant = (
+            abs(change) > threshold and
+            abs(delta) > noise * max(base_mad, new_mad)
+        )
+
+        if not significant:
+            verdict = "ok"
+        elif (delta > 0) == (unit in LOWER_IS_BETTER):
+            verdict = "SLOWER"
+        else:
+            verdict = "faster"
+
+        report.append((key, base, new, change, verdict))
+    return report
+
+#===============================================================================
+# Driver
+#===============================================================================
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description="Compares benchmark results against a baseline.")
+    parser.add_argument("baseline", help="baseline results (CSV)")
+    parser.add_argument("results", help="new results (CSV)")
+    parser.add_argument("--threshold", type=float, default=5.0,
+        help="minimum relative change to be reported, in percent (default: 5)")
+    parser.add_argument("--noise", type=float, default=3.0,
+        help="minimum change to be reported, in multiples of the MAD (default: 3)")
+    args = parser.parse_args(argv)
+
+    report = compare(load(args.baseline), load(args.results), args.threshold / 100.0, args.noise)
+
+    nslower = 0
+    nmissing = 0
+    for (benchmark, variant, metric, unit), base, new, change, verdict in report:
+        name = "%s/%s/%s" % (benchmark, variant, metric)
+        if verdict == "new":
+            print("%-8s %-60s %14s -> %14.0f %s" % (verdict, name, "-", new, unit))
+            continue
+        if verdict == "MISSING":
+            print("%-8s %-60s %14.0f -> %14s %s" % (verdict, name, base, "-", unit))
+            nmissing += 1
+            continue
+        print("%-8s %-60s %14.0f -> %14.0f %s (%+.1f%%)" % (verdict, name, base, new, unit, 100.0 * change))
+        if verdict == "SLOWER":
+            nslower += 1
+
+    if nmissing > 0:
+        sys.stderr.write("%d metric(s) missing from results\n" % nmissing)
+    if nslower > 0:
+        sys.stderr.write("%d significant slowdown(s) found\n" % nslower)
+    if (nslower > 0) or (nmissing > 0):
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
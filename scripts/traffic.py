@@ -0,0 +1,209 @@
+#!/usr/bin/env python3
+#
+# MIT License
+#
+# Copyright(c) 2011-2020 The Maintainers of Nanvix
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+
+"""
+Builds traffic matrices from console output.
+
+Collective benchmarks account, on every node, the bytes and messages
+exchanged with each peer and the time spent blocked on each transfer
+(see src/include/benchmark/traffic.h), and emit them as lines of
+semicolon-separated fields:
+
+    [traffic];version;benchmark;variant;node;direction;peer;bytes;messages;blocked
+
+For every run (benchmark and variant), this prints a PxP matrix of the
+bytes sent from each node (rows) to each node (columns), followed by the
+busiest endpoints. The NoC route of each transfer is not exposed to
+benchmarks, so the injection (outbound) and ejection (inbound) links of
+each node stand for the links of the network.
+
+Usage:
+
+    traffic.py [--format text|json] [--top N] [FILE...]
+"""
+
+import argparse
+import json
+import os
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+
+from collect import load
+
+#===============================================================================
+# Traffic Schema
+#===============================================================================
+
+# Tag that prefixes every traffic entry.
+TRAFFIC_TAG = "[traffic];"
+
+# Supported versions of the traffic schema.
+TRAFFIC_VERSIONS = (1,)
+
+# Fields of a traffic entry (version 1).
+TRAFFIC_FIELDS = (
+    "version",
+    "benchmark",
+    "variant",
+    "node",
+    "direction",
+    "peer",
+    "bytes",
+    "messages",
+    "blocked",
+)
+
+#===============================================================================
+# Parsing
+#===============================================================================
+
+def parse_traffic_line(line):
+    """Parses a line of console output.
+
+    Returns a traffic entry (as a dictionary) or None if the line carries
+    no traffic entry. Raises ValueError on malformed entries.
+    """
+    start = line.find(TRAFFIC_TAG)
+    if start < 0:
+        return None
+
+    fields = line[start + len(TRAFFIC_TAG):].rstrip("\r\n").split(";")
+    version = int(fields[0])
+    if version not in TRAFFIC_VERSIONS:
+        raise ValueError("unsupported traffic version %d" % version)
+    if len(fields) != len(TRAFFIC_FIELDS):
+        raise ValueError("expected %d fields, got %d" % (len(TRAFFIC_FIELDS), len(fields)))
+
+    entry = dict(zip(TRAFFIC_FIELDS, fields))
+    entry["version"] = version
+    for field in ("node", "peer", "bytes", "messages", "blocked"):
+        entry[field] = int(entry[field])
+    return entry
+
+#===============================================================================
+# Analysis
+#===============================================================================
+
+def analyze(entries):
+    """Builds the traffic matrix and endpoint totals of a run.
+
+    The matrix is built from what senders account. Inbound transfers
+    fill the gaps of senders that did not report, when their source is
+    known.
+    """
+    nodes = sorted({e["node"] for e in entries} | {e["peer"] for e in entries if e["peer"] >= 0})
+    matrix = {src: {dst: 0 for dst in nodes} for src in nodes}
+    reported = set()
+
+    for e in entries:
+        if e["direction"] == "send" and e["peer"] >= 0:
+            matrix[e["node"]][e["peer"]] += e["bytes"]
+            reported.add(e["node"])
+    for e in entries:
+        if e["direction"] == "recv" and e["peer"] >= 0 and e["peer"] not in reported:
+            matrix[e["peer"]][e["node"]] += e["bytes"]
+
+    endpoints = []
+    for node in nodes:
+        for direction in ("send", "recv"):
+            mine = [e for e in entries if e["node"] == node and e["direction"] == direction]
+            if direction == "send":
+                volume = sum(matrix[node].values())
+            else:
+                volume = sum(matrix[src][node] for src in nodes)
+            if volume == 0 and not mine:
+                continue
+            endpoints.append({
+                "node": node,
+                "link": "out" if direction == "send" else "in",
+                "bytes": volume,
+                "messages": sum(e["messages"] for e in mine),
+                "blocked": sum(e["blocked"] for e in mine),
+            })
+
+    total = sum(sum(row.values()) for row in matrix.values())
+    for endpoint in endpoints:
+        endpoint["share"] = endpoint["bytes"]/total if total else 0.0
+
+    return nodes, matrix, sorted(endpoints, key=lambda e: (e["bytes"], e["blocked"]), reverse=True)
+
+#===============================================================================
+# Output
+#===============================================================================
+
+def write_text(runs, stream, top):
+    for (benchmark, variant), (nodes, matrix, endpoints) in runs:
+        stream.write("%s %s: bytes sent (rows: source, columns: destination)\n" % (benchmark, variant))
+        width = max([len(str(v)) for row in matrix.values() for v in row.values()] + [len(str(n)) for n in nodes])
+        stream.write("%*s" % (width + 2, "") + "".join(" %*d" % (width, n) for n in nodes) + "\n")
+        for src in nodes:
+            stream.write("%*d  " % (width, src) + "".join(" %*d" % (width, matrix[src][dst]) for dst in nodes) + "\n")
+
+        stream.write("hotspots:\n")
+        for e in endpoints[:top]:
+            stream.write("  node %d %-3s %10d bytes (%5.1f%%) %8d messages %14d cycles blocked\n" % (
+                e["node"], e["link"], e["bytes"], 100*e["share"], e["messages"], e["blocked"]))
+        stream.write("\n")
+
+
+def write_json(runs, stream, top):
+    out = []
+    for (benchmark, variant), (nodes, matrix, endpoints) in runs:
+        out.append({
+            "benchmark": benchmark,
+            "variant": variant,
+            "nodes": nodes,
+            "matrix": [[matrix[src][dst] for dst in nodes] for src in nodes],
+            "hotspots": endpoints[:top],
+        })
+    json.dump(out, stream, indent=2)
+    stream.write("\n")
+
+#===============================================================================
+# Driver
+#===============================================================================
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description="Builds traffic matrices from console output.")
+    parser.add_argument("files", nargs="*", help="console output files (default: stdin)")
+    parser.add_argument("--format", choices=("text", "json"), default="text", help="output format")
+    parser.add_argument("--top", type=int, default=4, help="number of hotspots to show (default: 4)")
+    args = parser.parse_args(argv)
+
+    runs = {}
+    for entry in load(args.files, parse_traffic_line):
+        runs.setdefault((entry["benchmark"], entry["variant"]), []).append(entry)
+
+    runs = [(run, analyze(entries)) for run, entries in sorted(runs.items())]
+
+    writer = write_text if args.format == "text" else write_json
+    writer(runs, sys.stdout, args.top)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,535 @@
+/*
+ * MIT License
+ *
+ * Copyright(c) 2011-2020 The Maintainers of Nanvix
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <nanvix/runtime/runtime.h>
+#include <nanvix/runtime/barrier.h>
+#include <nanvix/sys/perf.h>
+#include <nanvix/limits.h>
+#include <nanvix/ulib.h>
+#include <benchmark/record.h>
+#include <benchmark/units.h>
+#include <benchmark/stats.h>
+#include <benchmark/calibration.h>
+
+/**
+ * @brief Number of iterations for the benchmark.
+ */
+#ifdef NDEBUG
+#define NITERATIONS 30
+#else
+#define NITERATIONS 1
+#endif
+
+static barrier_t barrier;
+static int nodes[NANVIX_PROC_MAX];
+
+/*============================================================================*
+ * Benchmark Kernel                                                           *
+ *============================================================================*/
+
+/**
+ * @brief Smallest edge of a tile (in elements).
+ */
+#ifndef TILE_MIN
+#define TILE_MIN 16
+#endif
+
+/**
+ * @brief Largest edge of a tile (in elements).
+ */
+#ifndef TILE_MAX
+#define TILE_MAX 64
+#endif
+
+/**
+ * @brief Maximum number of tile sizes in a sweep.
+ */
+#define TILE_SIZES_NUM 16
+
+/* Tile sizes double from TILE_MIN up to TILE_MAX. */
+#if (TILE_MIN < 1) || (TILE_MIN > TILE_MAX)
+#error "TILE_MIN must be in [1, TILE_MAX]"
+#elif (TILE_MIN << TILE_SIZES_NUM) <= TILE_MAX
+#error "too many tile sizes between TILE_MIN and TILE_MAX"
+#endif
+
+/**
+ * @brief Number of runs of the local kernel used to measure its rate.
+ */
+#ifndef RATE_SAMPLES
+#define RATE_SAMPLES 9
+#endif
+
+/**
+ * @brief Edge of cache blocks in the local kernel (in elements).
+ */
+#ifndef GEMM_BLOCK
+#define GEMM_BLOCK 16
+#endif
+
+/**
+ * @brief Port number used in the benchmark.
+ */
+#define PORT_NUM 0
+
+/**
+ * @name Algorithms
+ */
+/**@{*/
+#define ALGORITHM_SUMMA  0 /**< Row and column broadcasts. */
+#define ALGORITHM_CANNON 1 /**< Cannon shifts.             */
+#define ALGORITHMS_NUM   2 /**< Number of algorithms.      */
+/**@}*/
+
+/**
+ * @brief Names of algorithms.
+ */
+static const char *algorithms[ALGORITHMS_NUM] = { "summa", "cannon" };
+
+/**
+ * @brief Tiles.
+ */
+/**@{*/
+static float tileA[TILE_MAX*TILE_MAX]; /**< Local tile of A.        */
+static float tileB[TILE_MAX*TILE_MAX]; /**< Local tile of B.        */
+static float tileC[TILE_MAX*TILE_MAX]; /**< Local tile of C.        */
+static float bufA[TILE_MAX*TILE_MAX];  /**< Incoming tile of A.     */
+static float bufB[TILE_MAX*TILE_MAX];  /**< Incoming tile of B.     */
+/**@}*/
+
+/**
+ * @brief Portals.
+ */
+/**@{*/
+static int inportal;
+static int outportals[NANVIX_PROC_MAX];
+/**@}*/
+
+/**
+ * @brief Logical grid of nodes.
+ */
+static struct
+{
+	int q;   /**< Nodes along each axis. */
+	int row; /**< Row of this node.      */
+	int col; /**< Column of this node.   */
+} grid;
+
+/**
+ * @brief Index of the node at a position of the grid (wrapping around).
+ */
+static inline int grid_node(int row, int col)
+{
+	return (((row + grid.q) % grid.q)*grid.q + ((col + grid.q) % grid.q));
+}
+
+/**
+ * @brief Cache-blocked tile multiplication: C += A*B.
+ *
+ * @param a Tile of A.
+ * @param b Tile of B.
+ * @param c Tile of C.
+ * @param n Edge of tiles.
+ */
+static void gemm_local(const float *a, const float *b, float *c, int n)
+{
+	float aik;
+
+	for (int ii = 0; ii < n; ii += GEMM_BLOCK)
+	{
+		for (int kk = 0; kk < n; kk += GEMM_BLOCK)
+		{
+			for (int jj = 0; jj < n; jj += GEMM_BLOCK)
+			{
+				for (int i = ii; (i < ii + GEMM_BLOCK) && (i < n); i++)
+				{
+					for (int k = kk; (k < kk + GEMM_BLOCK) && (k < n); k++)
+					{
+						aik = a[i*n + k];
+						for (int j = jj; (j < jj + GEMM_BLOCK) && (j < n); j++)
+							c[i*n + j] += aik*b[k*n + j];
+					}
+				}
+			}
+		}
+	}
+}
+
+/**
+ * @brief Sends a tile asynchronously.
+ */
+static void tile_send(int to, const float *tile, size_t size)
+{
+	uassert(kportal_awrite(outportals[to], tile, size) == (ssize_t) size);
+}
+
+/**
+ * @brief Receives a tile.
+ */
+static void tile_recv(int from, float *tile, size_t size)
+{
+	uassert(kportal_allow(inportal, PROCESSOR_NODENUM_LEADER + from, PORT_NUM) == 0);
+	uassert(kportal_read(inportal, tile, size) == (ssize_t) size);
+}
+
+/**
+ * @brief Waits for a tile to be sent.
+ */
+static void tile_wait(int to)
+{
+	uassert(kportal_wait(outportals[to]) == 0);
+}
+
+/**
+ * @brief Exchanges tiles: sends @p tile to @p to, and receives it from @p from.
+ */
+static void tile_shift(int to, int from, float *tile, float *buf, int n)
+{
+	size_t size = n*n*sizeof(float);
+
+	if (to == (grid.row*grid.q + grid.col))
+		return;
+
+	tile_send(to, tile, size);
+	tile_recv(from, buf, size);
+	tile_wait(to);
+
+	umemcpy(tile, buf, size);
+}
+
+/**
+ * @brief SUMMA: at step k, the owners of column k of A and row k of B
+ * broadcast their tiles along rows and columns, respectively.
+ *
+ * @returns Cycles spent in communication.
+ */
+static uint64_t gemm_summa(int n)
+{
+	int me;
+	int owner;
+	uint64_t t0, t1, comm;
+	const float *a, *b;
+	size_t size = n*n*sizeof(float);
+
+	me = grid_node(grid.row, grid.col);
+	comm = 0;
+
+	for (int k = 0; k < grid.q; k++)
+	{
+		kclock(&t0);
+
+			/* Post broadcasts of owned tiles. */
+			if (grid.col == k)
+			{
+				for (int j = 0; j < grid.q; j++)
+				{
+					if (j != k)
+						tile_send(grid_node(grid.row, j), tileA, size);
+				}
+			}
+			if (grid.row == k)
+			{
+				for (int i = 0; i < grid.q; i++)
+				{
+					if (i != k)
+						tile_send(grid_node(i, grid.col), tileB, size);
+				}
+			}
+
+			/* Receive tiles of others. */
+			if ((owner = grid_node(grid.row, k)) != me)
+				tile_recv(owner, bufA, size);
+			if ((owner = grid_node(k, grid.col)) != me)
+				tile_recv(owner, bufB, size);
+
+			/* Complete broadcasts. */
+			for (int j = 0; (grid.col == k) && (j < grid.q); j++)
+			{
+				if (j != k)
+					tile_wait(grid_node(grid.row, j));
+			}
+			for (int i = 0; (grid.row == k) && (i < grid.q); i++)
+			{
+				if (i != k)
+					tile_wait(grid_node(i, grid.col));
+			}
+
+		kclock(&t1);
+		comm += benchmark_elapsed(t0, t1);
+
+		a = (grid.col == k) ? tileA : bufA;
+		b = (grid.row == k) ? tileB : bufB;
+		gemm_local(a, b, tileC, n);
+	}
+
+	return (comm);
+}
+
+/**
+ * @brief Cannon: tiles are skewed once, then multiplied and shifted
+ * (A left, B up) at each step.
+ *
+ * @returns Cycles spent in communication.
+ */
+static uint64_t gemm_cannon(int n)
+{
+	uint64_t t0, t1, comm;
+
+	comm = 0;
+
+	/* Skew. */
+	kclock(&t0);
+		tile_shift(
+			grid_node(grid.row, grid.col - grid.row),
+			grid_node(grid.row, grid.col + grid.row),
+			tileA, bufA, n
+		);
+		tile_shift(
+			grid_node(grid.row - grid.col, grid.col),
+			grid_node(grid.row + grid.col, grid.col),
+			tileB, bufB, n
+		);
+	kclock(&t1);
+	comm += benchmark_elapsed(t0, t1);
+
+	for (int k = 0; k < grid.q; k++)
+	{
+		gemm_local(tileA, tileB, tileC, n);
+
+		if (k == (grid.q - 1))
+			break;
+
+		kclock(&t0);
+			tile_shift(grid_node(grid.row, grid.col - 1), grid_node(grid.row, grid.col + 1), tileA, bufA, n);
+			tile_shift(grid_node(grid.row - 1, grid.col), grid_node(grid.row + 1, grid.col), tileB, bufB, n);
+		kclock(&t1);
+		comm += benchmark_elapsed(t0, t1);
+	}
+
+	return (comm);
+}
+
+/**
+ * @brief Fills tiles.
+ *
+ * Tile (i, k) of A and tile (k, j) of B are filled with k + 1, so every
+ * element of C is n*(1^2 + 2^2 + ... + q^2) if, and only if, matching
+ * tiles were multiplied.
+ */
+static void tiles_init(int n)
+{
+	for (int i = 0; i < n*n; i++)
+	{
+		tileA[i] = (float) (grid.col + 1);
+		tileB[i] = (float) (grid.row + 1);
+		tileC[i] = 0.0f;
+	}
+}
+
+/**
+ * @brief Checks the local tile of C.
+ */
+static void tiles_check(int n)
+{
+	float expected;
+	float diff;
+
+	expected = (float) n*(grid.q*(grid.q + 1)*(2*grid.q + 1)/6);
+
+	for (int i = 0; i < n*n; i++)
+	{
+		diff = tileC[i] - expected;
+		uassert((diff < 0.5f) && (diff > -0.5f));
+	}
+}
+
+/**
+ * @brief Measures the rate of the local kernel on a single tile.
+ *
+ * The kernel is run once to warm up, and then RATE_SAMPLES times, and
+ * the median run time is used.
+ *
+ * @returns The rate in floating-point operations per second.
+ */
+static uint64_t gemm_local_rate(int n)
+{
+	uint64_t t0, t1;
+	uint64_t samples[RATE_SAMPLES];
+
+	tiles_init(n);
+	gemm_local(tileA, tileB, tileC, n);
+
+	for (int i = 0; i < RATE_SAMPLES; i++)
+	{
+		tiles_init(n);
+
+		kclock(&t0);
+			gemm_local(tileA, tileB, tileC, n);
+		kclock(&t1);
+
+		samples[i] = benchmark_elapsed(t0, t1);
+	}
+
+	stats_sort(samples, RATE_SAMPLES);
+
+	return (benchmark_bandwidth(2*((uint64_t) n)*n*n, stats_percentile(samples, RATE_SAMPLES, 50)));
+}
+
+/**
+ * @brief Runs a distributed matrix multiplication.
+ *
+ * @param algorithm Algorithm.
+ * @param q         Nodes along each axis of the grid.
+ * @param n         Edge of tiles.
+ * @param rate1     Single-node rate of the local kernel.
+ */
+static void benchmark_gemm(int algorithm, int q, int n, uint64_t rate1)
+{
+	int me;
+	uint64_t t0, t1, elapsed;
+	uint64_t comm;
+	uint64_t flops, rate;
+	char variant[BENCHMARK_VARIANT_MAX];
+
+	me = knode_get_num() - PROCESSOR_NODENUM_LEADER;
+
+	grid.q = q;
+	grid.row = me/q;
+	grid.col = me % q;
+
+	usprintf(variant, "gemm:algo=%s,nodes=%d,n=%d,tile=%d",
+		algorithms[algorithm],
+		q*q,
+		q*n,
+		n
+	);
+
+	for (int i = 1; i <= NITERATIONS; i++)
+	{
+		if (me < q*q)
+			tiles_init(n);
+
+		uassert(barrier_wait(barrier) == 0);
+		kclock(&t0);
+
+			comm = 0;
+			if (me < q*q)
+				comm = (algorithm == ALGORITHM_SUMMA) ? gemm_summa(n) : gemm_cannon(n);
+
+		uassert(barrier_wait(barrier) == 0);
+		kclock(&t1);
+		elapsed = benchmark_elapsed(t0, t1);
+
+		if (me >= q*q)
+			continue;
+
+		tiles_check(n);
+
+		/* Dump statistics. */
+		benchmark_record_time("gemm", variant, i, "comm", comm);
+		if (me == 0)
+		{
+			flops = 2*((uint64_t) q*n)*(q*n)*(q*n);
+			rate = benchmark_bandwidth(flops, elapsed);
+
+			benchmark_record_time("gemm", variant, i, "time", elapsed);
+			benchmark_record("gemm", variant, i, "rate", rate, BENCHMARK_UNIT_FLOPS);
+			if (rate1 > 0)
+			{
+				benchmark_record("gemm", variant, i, "efficiency",
+					(rate*1000)/(((uint64_t) q*q)*rate1),
+					BENCHMARK_UNIT_PERMILLE
+				);
+			}
+		}
+	}
+}
+
+/**
+ * @brief Benchmarks distributed dense matrix multiplication.
+ */
+static void benchmark_app_gemm(void)
+{
+	int me;
+	uint64_t rates[TILE_SIZES_NUM];
+
+	me = knode_get_num() - PROCESSOR_NODENUM_LEADER;
+
+	/* Single-node rates of the local kernel, for efficiency. */
+	for (int n = TILE_MIN, k = 0; (n <= TILE_MAX) && (k < TILE_SIZES_NUM); n *= 2, k++)
+		rates[k] = gemm_local_rate(n);
+
+	/* Build list of nodes. */
+	for (int i = 0; i < NANVIX_PROC_MAX; i++)
+		nodes[i] = PROCESSOR_NODENUM_LEADER + i;
+
+	barrier = barrier_create(nodes, NANVIX_PROC_MAX);
+	uassert(BARRIER_IS_VALID(barrier));
+
+	/* Establish connections. */
+	uassert((inportal = kportal_create(knode_get_num(), PORT_NUM)) >= 0);
+	for (int i = 0; i < NANVIX_PROC_MAX; i++)
+	{
+		if (i != me)
+			uassert((outportals[i] = kportal_open(knode_get_num(), nodes[i], PORT_NUM)) >= 0);
+	}
+
+		for (int q = 1; q*q <= NANVIX_PROC_MAX; q++)
+		{
+			for (int n = TILE_MIN, k = 0; (n <= TILE_MAX) && (k < TILE_SIZES_NUM); n *= 2, k++)
+			{
+				for (int algorithm = 0; algorithm < ALGORITHMS_NUM; algorithm++)
+					benchmark_gemm(algorithm, q, n, rates[k]);
+			}
+		}
+
+	/* House keeping. */
+	for (int i = 0; i < NANVIX_PROC_MAX; i++)
+	{
+		if (i != me)
+			uassert(kportal_close(outportals[i]) == 0);
+	}
+	uassert(kportal_unlink(inportal) == 0);
+
+	uassert(barrier_destroy(barrier) == 0);
+}
+
+/*============================================================================*
+ * Benchmark Driver                                                           *
+ *============================================================================*/
+
+/**
+ * @brief Launches a benchmark.
+ */
+int __main3(int argc, const char *argv[])
+{
+	((void) argc);
+	((void) argv);
+
+	benchmark_calibrate();
+
+	benchmark_app_gemm();
+
+	return (0);
+}
@@ -0,0 +1,470 @@
+/*
+ * MIT License
+ *
+ * Copyright(c) 2011-2020 The Maintainers of Nanvix
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <nanvix/runtime/runtime.h>
+#include <nanvix/runtime/barrier.h>
+#include <nanvix/sys/perf.h>
+#include <nanvix/limits.h>
+#include <nanvix/ulib.h>
+#include <benchmark/record.h>
+#include <benchmark/units.h>
+#include <benchmark/calibration.h>
+
+/**
+ * @brief Number of iterations for the benchmark.
+ */
+#ifdef NDEBUG
+#define NITERATIONS 30
+#else
+#define NITERATIONS 1
+#endif
+
+static barrier_t barrier;
+static int nodes[NANVIX_PROC_MAX];
+
+/*============================================================================*
+ * Benchmark Kernel                                                           *
+ *============================================================================*/
+
+/**
+ * @brief Number of points per node.
+ */
+#ifndef NPOINTS
+#define NPOINTS 4096
+#endif
+
+/**
+ * @brief Dimension of points.
+ */
+#ifndef NDIMS
+#define NDIMS 4
+#endif
+
+/**
+ * @brief Number of clusters (k).
+ */
+#ifndef NCENTROIDS
+#define NCENTROIDS 8
+#endif
+
+/**
+ * @brief Number of Lloyd iterations per run.
+ */
+#ifndef NSTEPS
+#define NSTEPS 10
+#endif
+
+/**
+ * @brief Port number used by portals.
+ */
+#define PORT_NUM 0
+
+/**
+ * @brief Port number used by mailboxes.
+ */
+#define MAILBOX_PORT 1
+
+/**
+ * @brief Size of the partial sums of a node (in floats).
+ *
+ * For each centroid, the sum of its points along each dimension,
+ * followed by the number of its points.
+ */
+#define PARTIAL_SIZE (NCENTROIDS*(NDIMS + 1))
+
+/**
+ * @brief Size of the centroids (in floats).
+ */
+#define CENTROIDS_SIZE (NCENTROIDS*NDIMS)
+
+/**
+ * @brief Floats carried by a mailbox message, after the chunk index.
+ */
+#define CHUNK_SIZE ((int) (KMAILBOX_MESSAGE_SIZE/sizeof(float)) - 1)
+
+/**
+ * @brief Number of mailbox messages needed to carry a buffer.
+ */
+#define NCHUNKS(n) (((n) + CHUNK_SIZE - 1)/CHUNK_SIZE)
+
+/**
+ * @name Reduction Methods
+ */
+/**@{*/
+#define REDUCE_MAILBOX 0 /**< Mailboxes. */
+#define REDUCE_PORTAL  1 /**< Portals.   */
+#define REDUCE_NUM     2 /**< Number of methods. */
+/**@}*/
+
+/**
+ * @brief Names of reduction methods.
+ */
+static const char *reductions[REDUCE_NUM] = { "mailbox", "portal" };
+
+/**
+ * @brief Points of this node.
+ */
+static float points[NPOINTS][NDIMS];
+
+/**
+ * @brief Centroids.
+ */
+static float centroids[CENTROIDS_SIZE];
+
+/**
+ * @brief Partial sums.
+ */
+/**@{*/
+static float partial[PARTIAL_SIZE];   /**< Of this node.        */
+static float incoming[PARTIAL_SIZE];  /**< Of a remote node.    */
+/**@}*/
+
+/**
+ * @brief Communication endpoints.
+ */
+/**@{*/
+static int inportal;
+static int outportals[NANVIX_PROC_MAX];
+static int inbox;
+static int outboxes[NANVIX_PROC_MAX];
+/**@}*/
+
+/**
+ * @brief Draws a pseudo-random number in [0, 1).
+ */
+static float lcg_next(uint32_t *x)
+{
+	*x = (*x)*1664525u + 1013904223u;
+
+	return ((float) ((*x) >> 8)/16777216.0f);
+}
+
+/**
+ * @brief Generates points and initial centroids.
+ *
+ * Points are scattered around NCENTROIDS hidden centers, which are the
+ * same on every node. Initial centroids are drawn from the same seed on
+ * every node, so no broadcast is needed.
+ */
+static void kmeans_init(int me)
+{
+	uint32_t x;
+	float centers[NCENTROIDS][NDIMS];
+
+	x = 12345u;
+	for (int c = 0; c < NCENTROIDS; c++)
+	{
+		for (int d = 0; d < NDIMS; d++)
+			centers[c][d] = 10.0f*lcg_next(&x);
+	}
+
+	for (int i = 0; i < CENTROIDS_SIZE; i++)
+		centroids[i] = 10.0f*lcg_next(&x);
+
+	x = 0x9e3779b9u*((uint32_t) me + 1);
+	for (int i = 0; i < NPOINTS; i++)
+	{
+		int c = i % NCENTROIDS;
+
+		for (int d = 0; d < NDIMS; d++)
+			points[i][d] = centers[c][d] + lcg_next(&x) - 0.5f;
+	}
+}
+
+/**
+ * @brief Assigns points to their nearest centroids and sums them up.
+ */
+static void kmeans_assign(void)
+{
+	int best;
+	float dist, bestdist, diff;
+
+	umemset(partial, 0, sizeof(partial));
+
+	for (int i = 0; i < NPOINTS; i++)
+	{
+		best = 0;
+		bestdist = 0.0f;
+
+		for (int c = 0; c < NCENTROIDS; c++)
+		{
+			dist = 0.0f;
+			for (int d = 0; d < NDIMS; d++)
+			{
+				diff = points[i][d] - centroids[c*NDIMS + d];
+				dist += diff*diff;
+			}
+
+			if ((c == 0) || (dist < bestdist))
+			{
+				best = c;
+				bestdist = dist;
+			}
+		}
+
+		for (int d = 0; d < NDIMS; d++)
+			partial[best*(NDIMS + 1) + d] += points[i][d];
+		partial[best*(NDIMS + 1) + NDIMS] += 1.0f;
+	}
+}
+
+/**
+ * @brief Computes new centroids from global sums.
+ */
+static void kmeans_update(void)
+{
+	float count;
+
+	for (int c = 0; c < NCENTROIDS; c++)
+	{
+		count = partial[c*(NDIMS + 1) + NDIMS];
+
+		/* Empty clusters keep their centroid. */
+		if (count < 0.5f)
+			continue;
+
+		for (int d = 0; d < NDIMS; d++)
+			centroids[c*NDIMS + d] = partial[c*(NDIMS + 1) + d]/count;
+	}
+}
+
+/**
+ * @brief Sends a buffer through mailboxes, in chunks.
+ */
+static void mailbox_send(int to, const float *buf, int n)
+{
+	float msg[KMAILBOX_MESSAGE_SIZE/sizeof(float)];
+
+	umemset(msg, 0, sizeof(msg));
+
+	for (int k = 0; k < NCHUNKS(n); k++)
+	{
+		int len = ((n - k*CHUNK_SIZE) < CHUNK_SIZE) ? (n - k*CHUNK_SIZE) : CHUNK_SIZE;
+
+		msg[0] = (float) k;
+		umemcpy(&msg[1], &buf[k*CHUNK_SIZE], len*sizeof(float));
+		uassert(kmailbox_write(outboxes[to], msg, KMAILBOX_MESSAGE_SIZE) == KMAILBOX_MESSAGE_SIZE);
+	}
+}
+
+/**
+ * @brief Receives a chunk through mailboxes.
+ *
+ * @param buf Target buffer.
+ * @param n   Size of the buffer (in floats).
+ * @param add Add the chunk to the buffer, rather than copy it?
+ */
+static void mailbox_recv(float *buf, int n, int add)
+{
+	int k, len;
+	float msg[KMAILBOX_MESSAGE_SIZE/sizeof(float)];
+
+	uassert(kmailbox_read(inbox, msg, KMAILBOX_MESSAGE_SIZE) == KMAILBOX_MESSAGE_SIZE);
+
+	k = (int) msg[0];
+	len = ((n - k*CHUNK_SIZE) < CHUNK_SIZE) ? (n - k*CHUNK_SIZE) : CHUNK_SIZE;
+
+	for (int i = 0; i < len; i++)
+	{
+		if (add)
+			buf[k*CHUNK_SIZE + i] += msg[1 + i];
+		else
+			buf[k*CHUNK_SIZE + i] = msg[1 + i];
+	}
+}
+
+/**
+ * @brief Combines partial sums and distributes new centroids.
+ *
+ * Partial sums are reduced at the leader, which computes the new
+ * centroids and broadcasts them back.
+ *
+ * @param me     Index of this node.
+ * @param method Reduction method.
+ */
+static void kmeans_allreduce(int me, int method)
+{
+	size_t partialsz = PARTIAL_SIZE*sizeof(float);
+	size_t centroidsz = CENTROIDS_SIZE*sizeof(float);
+
+	if (me == 0)
+	{
+		if (method == REDUCE_MAILBOX)
+		{
+			/* Chunks may arrive in any order, but sums commute. */
+			for (int i = 0; i < (NANVIX_PROC_MAX - 1)*NCHUNKS(PARTIAL_SIZE); i++)
+				mailbox_recv(partial, PARTIAL_SIZE, 1);
+		}
+		else
+		{
+			for (int i = 1; i < NANVIX_PROC_MAX; i++)
+			{
+				uassert(kportal_allow(inportal, PROCESSOR_NODENUM_LEADER + i, PORT_NUM) == 0);
+				uassert(kportal_read(inportal, incoming, partialsz) == (ssize_t) partialsz);
+
+				for (int j = 0; j < PARTIAL_SIZE; j++)
+					partial[j] += incoming[j];
+			}
+		}
+
+		kmeans_update();
+
+		for (int i = 1; i < NANVIX_PROC_MAX; i++)
+		{
+			if (method == REDUCE_MAILBOX)
+				mailbox_send(i, centroids, CENTROIDS_SIZE);
+			else
+				uassert(kportal_write(outportals[i], centroids, centroidsz) == (ssize_t) centroidsz);
+		}
+	}
+	else
+	{
+		if (method == REDUCE_MAILBOX)
+		{
+			mailbox_send(0, partial, PARTIAL_SIZE);
+			for (int i = 0; i < NCHUNKS(CENTROIDS_SIZE); i++)
+				mailbox_recv(centroids, CENTROIDS_SIZE, 0);
+		}
+		else
+		{
+			uassert(kportal_write(outportals[0], partial, partialsz) == (ssize_t) partialsz);
+			uassert(kportal_allow(inportal, PROCESSOR_NODENUM_LEADER, PORT_NUM) == 0);
+			uassert(kportal_read(inportal, centroids, centroidsz) == (ssize_t) centroidsz);
+		}
+	}
+}
+
+/**
+ * @brief Runs k-means.
+ *
+ * @param method Reduction method.
+ */
+static void benchmark_kmeans(int method)
+{
+	int me;
+	uint64_t t0, t1, t2;
+	uint64_t compute, comm;
+	char variant[BENCHMARK_VARIANT_MAX];
+
+	me = knode_get_num() - PROCESSOR_NODENUM_LEADER;
+
+	usprintf(variant, "kmeans:points=%d,dims=%d,k=%d,reduce=%s",
+		NPOINTS,
+		NDIMS,
+		NCENTROIDS,
+		reductions[method]
+	);
+
+	for (int i = 1; i <= NITERATIONS; i++)
+	{
+		kmeans_init(me);
+
+		uassert(barrier_wait(barrier) == 0);
+
+		compute = comm = 0;
+		for (int s = 0; s < NSTEPS; s++)
+		{
+			kclock(&t0);
+				kmeans_assign();
+			kclock(&t1);
+				kmeans_allreduce(me, method);
+			kclock(&t2);
+
+			compute += benchmark_elapsed(t0, t1);
+			comm += benchmark_elapsed(t1, t2);
+		}
+
+		/* Dump statistics (per Lloyd iteration). */
+		benchmark_record_time("kmeans", variant, i, "compute", compute/NSTEPS);
+		benchmark_record_time("kmeans", variant, i, "comm", comm/NSTEPS);
+		benchmark_record_time("kmeans", variant, i, "iteration", (compute + comm)/NSTEPS);
+	}
+}
+
+/**
+ * @brief Benchmarks k-means clustering.
+ */
+static void benchmark_app_kmeans(void)
+{
+	int me;
+
+	me = knode_get_num() - PROCESSOR_NODENUM_LEADER;
+
+	/* Build list of nodes. */
+	for (int i = 0; i < NANVIX_PROC_MAX; i++)
+		nodes[i] = PROCESSOR_NODENUM_LEADER + i;
+
+	barrier = barrier_create(nodes, NANVIX_PROC_MAX);
+	uassert(BARRIER_IS_VALID(barrier));
+
+	/* Establish connections. */
+	uassert((inportal = kportal_create(knode_get_num(), PORT_NUM)) >= 0);
+	uassert((inbox = kmailbox_create(knode_get_num(), MAILBOX_PORT)) >= 0);
+	for (int i = 0; i < NANVIX_PROC_MAX; i++)
+	{
+		if (i == me)
+			continue;
+
+		uassert((outportals[i] = kportal_open(knode_get_num(), nodes[i], PORT_NUM)) >= 0);
+		uassert((outboxes[i] = kmailbox_open(nodes[i], MAILBOX_PORT)) >= 0);
+	}
+
+	uassert(barrier_wait(barrier) == 0);
+
+		for (int method = 0; method < REDUCE_NUM; method++)
+			benchmark_kmeans(method);
+
+	/* House keeping. */
+	for (int i = 0; i < NANVIX_PROC_MAX; i++)
+	{
+		if (i == me)
+			continue;
+
+		uassert(kmailbox_close(outboxes[i]) == 0);
+		uassert(kportal_close(outportals[i]) == 0);
+	}
+	uassert(kmailbox_unlink(inbox) == 0);
+	uassert(kportal_unlink(inportal) == 0);
+
+	uassert(barrier_destroy(barrier) == 0);
+}
+
+/*============================================================================*
+ * Benchmark Driver                                                           *
+ *============================================================================*/
+
+/**
+ * @brief Launches a benchmark.
+ */
+int __main3(int argc, const char *argv[])
+{
+	((void) argc);
+	((void) argv);
+
+	benchmark_calibrate();
+
+	benchmark_app_kmeans();
+
+	return (0);
+}
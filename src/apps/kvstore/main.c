@@ -0,0 +1,486 @@
+/*
+ * MIT License
+ *
+ * Copyright(c) 2011-2020 The Maintainers of Nanvix
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <nanvix/runtime/runtime.h>
+#include <nanvix/runtime/barrier.h>
+#include <nanvix/sys/perf.h>
+#include <nanvix/limits.h>
+#include <nanvix/ulib.h>
+#include <benchmark/record.h>
+#include <benchmark/units.h>
+#include <benchmark/stats.h>
+#include <benchmark/calibration.h>
+
+/**
+ * @brief Number of iterations for the benchmark.
+ */
+#ifdef NDEBUG
+#define NITERATIONS 30
+#else
+#define NITERATIONS 1
+#endif
+
+static barrier_t barrier;
+static int nodes[NANVIX_PROC_MAX];
+
+/*============================================================================*
+ * Benchmark Kernel                                                           *
+ *============================================================================*/
+
+/**
+ * @brief Number of keys in the store.
+ */
+#ifndef NKEYS
+#define NKEYS 1024
+#endif
+
+/**
+ * @brief Size of a value (in bytes).
+ */
+#ifndef VALUE_SIZE
+#define VALUE_SIZE 128
+#endif
+
+/**
+ * @brief Number of operations per iteration.
+ */
+#ifndef NOPS
+#define NOPS 512
+#endif
+
+/**
+ * @brief Number of slots in the index (power of two).
+ */
+#define NSLOTS (4*NKEYS)
+
+/**
+ * @brief Index entries per remote block.
+ */
+#define SLOTS_PER_BLOCK ((int) (RMEM_BLOCK_SIZE/sizeof(struct entry)))
+
+/**
+ * @brief Values per remote block.
+ */
+#define VALUES_PER_BLOCK (RMEM_BLOCK_SIZE/VALUE_SIZE)
+
+/**
+ * @brief Number of remote blocks of the index.
+ */
+#define INDEX_BLOCKS (NSLOTS/SLOTS_PER_BLOCK)
+
+/**
+ * @brief Number of remote blocks of value slabs.
+ */
+#define SLAB_BLOCKS ((NKEYS + VALUES_PER_BLOCK - 1)/VALUES_PER_BLOCK)
+
+/**
+ * @brief Fixed-point scale of the Zipfian distribution.
+ */
+#define ZIPF_SCALE (1 << 30)
+
+/**
+ * @name Operations.
+ */
+/**@{*/
+#define OP_READ   0 /**< Read.              */
+#define OP_UPDATE 1 /**< Update.            */
+#define OP_RMW    2 /**< Read-modify-write. */
+/**@}*/
+
+/**
+ * @brief Workload mix.
+ */
+struct workload
+{
+	const char *name; /**< YCSB name.                          */
+	int reads;        /**< Reads (percent).                    */
+	int updates;      /**< Updates (percent).                  */
+	int rmws;         /**< Read-modify-writes (percent).       */
+};
+
+/**
+ * @brief Workload mixes (YCSB core workloads without inserts and scans).
+ */
+static const struct workload workloads[] = {
+	{ "A", 50, 50,  0 },
+	{ "B", 95,  5,  0 },
+	{ "C", 100, 0,  0 },
+	{ "F", 50,  0, 50 },
+};
+
+/**
+ * @brief Entry of the index.
+ */
+struct entry
+{
+	uint32_t key;  /**< Key plus one (zero if empty). */
+	uint32_t slot; /**< Slot of the value.            */
+};
+
+/**
+ * @brief Value.
+ */
+struct value
+{
+	uint32_t key;                               /**< Owning key.     */
+	uint32_t version;                           /**< Update counter. */
+	char data[VALUE_SIZE - 2*sizeof(uint32_t)]; /**< Payload.        */
+};
+
+/**
+ * @brief Remote blocks.
+ */
+/**@{*/
+static void *index_blocks[INDEX_BLOCKS];
+static void *slab_blocks[SLAB_BLOCKS];
+/**@}*/
+
+/**
+ * @brief Cumulative distribution of key ranks.
+ */
+static uint32_t zipf_cdf[NKEYS];
+
+/**
+ * @brief Operation latencies.
+ */
+static uint64_t latencies[NOPS];
+
+/**
+ * @brief State of the random number generator.
+ */
+static uint32_t seed;
+
+/**
+ * @brief Generates a random number.
+ */
+static uint32_t kv_random(void)
+{
+	seed = seed*1664525u + 1013904223u;
+	return (seed >> 2);
+}
+
+/**
+ * @brief Builds the Zipfian distribution (exponent one).
+ */
+static void zipf_init(void)
+{
+	double zeta = 0.0;
+	double sum = 0.0;
+
+	for (int i = 1; i <= NKEYS; i++)
+		zeta += 1.0/i;
+
+	for (int i = 1; i <= NKEYS; i++)
+	{
+		sum += 1.0/i;
+		zipf_cdf[i - 1] = (uint32_t) ((sum/zeta)*(ZIPF_SCALE - 1));
+	}
+
+	zipf_cdf[NKEYS - 1] = ZIPF_SCALE - 1;
+}
+
+/**
+ * @brief Draws a key.
+ *
+ * A rank is drawn from the Zipfian distribution, and scrambled so that
+ * popular keys spread over the index.
+ */
+static uint32_t zipf_next(void)
+{
+	uint32_t u;
+	int lo = 0, hi = NKEYS - 1;
+
+	u = kv_random() & (ZIPF_SCALE - 1);
+
+	while (lo < hi)
+	{
+		int mid = (lo + hi)/2;
+
+		if (zipf_cdf[mid] < u)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return ((uint32_t) (((uint64_t) lo*2654435761u) % NKEYS));
+}
+
+/**
+ * @brief Hashes a key.
+ */
+static uint32_t kv_hash(uint32_t key)
+{
+	key ^= key >> 16;
+	key *= 0x45d9f3bu;
+	key ^= key >> 16;
+
+	return (key & (NSLOTS - 1));
+}
+
+/**
+ * @brief Gets the remote address of an index entry.
+ */
+static void *entry_addr(uint32_t i)
+{
+	return ((char *) index_blocks[i/SLOTS_PER_BLOCK] + (i%SLOTS_PER_BLOCK)*sizeof(struct entry));
+}
+
+/**
+ * @brief Gets the remote address of a value.
+ */
+static void *value_addr(uint32_t slot)
+{
+	return ((char *) slab_blocks[slot/VALUES_PER_BLOCK] + (slot%VALUES_PER_BLOCK)*VALUE_SIZE);
+}
+
+/**
+ * @brief Looks up a key in the index.
+ *
+ * @returns The slot of the value of @p key.
+ */
+static uint32_t kv_lookup(uint32_t key)
+{
+	struct entry e;
+
+	for (uint32_t i = kv_hash(key); ; i = (i + 1) & (NSLOTS - 1))
+	{
+		uassert(nanvix_vmem_read(&e, entry_addr(i), sizeof(e)) == sizeof(e));
+		uassert(e.key != 0);
+
+		if (e.key == key + 1)
+			return (e.slot);
+	}
+}
+
+/**
+ * @brief Loads all keys into the store.
+ */
+static void kv_load(void)
+{
+	struct entry e;
+	struct value v;
+	uint32_t i;
+
+	umemset(&e, 0, sizeof(e));
+	for (i = 0; i < NSLOTS; i++)
+		uassert(nanvix_vmem_write(entry_addr(i), &e, sizeof(e)) == sizeof(e));
+
+	umemset(&v, 0, sizeof(v));
+	for (uint32_t key = 0; key < NKEYS; key++)
+	{
+		for (i = kv_hash(key); ; i = (i + 1) & (NSLOTS - 1))
+		{
+			uassert(nanvix_vmem_read(&e, entry_addr(i), sizeof(e)) == sizeof(e));
+			if (e.key == 0)
+				break;
+		}
+
+		e.key = key + 1;
+		e.slot = key;
+		uassert(nanvix_vmem_write(entry_addr(i), &e, sizeof(e)) == sizeof(e));
+
+		v.key = key;
+		uassert(nanvix_vmem_write(value_addr(key), &v, sizeof(v)) == sizeof(v));
+	}
+}
+
+/**
+ * @brief Runs an operation.
+ */
+static void kv_operation(int op, uint32_t key)
+{
+	uint32_t slot;
+	struct value v;
+
+	slot = kv_lookup(key);
+
+	switch (op)
+	{
+		case OP_READ:
+			uassert(nanvix_vmem_read(&v, value_addr(slot), sizeof(v)) == sizeof(v));
+			uassert(v.key == key);
+			break;
+
+		case OP_UPDATE:
+			v.key = key;
+			v.version = kv_random();
+			umemset(v.data, (int) v.version, sizeof(v.data));
+			uassert(nanvix_vmem_write(value_addr(slot), &v, sizeof(v)) == sizeof(v));
+			break;
+
+		case OP_RMW:
+			uassert(nanvix_vmem_read(&v, value_addr(slot), sizeof(v)) == sizeof(v));
+			uassert(v.key == key);
+			v.version++;
+			umemset(v.data, (int) v.version, sizeof(v.data));
+			uassert(nanvix_vmem_write(value_addr(slot), &v, sizeof(v)) == sizeof(v));
+			break;
+
+		default:
+			uassert(0);
+	}
+}
+
+/**
+ * @brief Runs a workload mix.
+ *
+ * @param w        Workload mix.
+ * @param nclients Number of client clusters.
+ */
+static void benchmark_kvstore(const struct workload *w, int nclients)
+{
+	int me;
+	int op;
+	uint32_t r;
+	uint64_t t0, t1, elapsed;
+	uint64_t op0, op1, local;
+	char variant[BENCHMARK_VARIANT_MAX];
+
+	me = knode_get_num() - PROCESSOR_NODENUM_LEADER;
+
+	usprintf(variant, "kvstore:workload=%s,clients=%d,keys=%d,value=%d",
+		w->name, nclients, NKEYS, VALUE_SIZE
+	);
+
+	for (int i = 1; i <= NITERATIONS; i++)
+	{
+		seed = 0x9e3779b9u*((uint32_t) me + 1) + (uint32_t) i;
+
+		uassert(barrier_wait(barrier) == 0);
+		kclock(&t0);
+
+			local = 0;
+			if (me < nclients)
+			{
+				for (int j = 0; j < NOPS; j++)
+				{
+					r = kv_random()%100;
+					op = (r < (uint32_t) w->reads) ? OP_READ :
+						(r < (uint32_t) (w->reads + w->updates)) ? OP_UPDATE : OP_RMW;
+
+					kclock(&op0);
+						kv_operation(op, zipf_next());
+					kclock(&op1);
+
+					latencies[j] = benchmark_elapsed(op0, op1);
+					local += latencies[j];
+				}
+			}
+
+		uassert(barrier_wait(barrier) == 0);
+		kclock(&t1);
+		elapsed = benchmark_elapsed(t0, t1);
+
+		if (me >= nclients)
+			continue;
+
+		/* Dump statistics. */
+		stats_sort(latencies, NOPS);
+		benchmark_record_time("kvstore", variant, i, "p50", stats_percentile(latencies, NOPS, 50));
+		benchmark_record_time("kvstore", variant, i, "p90", stats_percentile(latencies, NOPS, 90));
+		benchmark_record_time("kvstore", variant, i, "p99", stats_percentile(latencies, NOPS, 99));
+		benchmark_record_time("kvstore", variant, i, "max", latencies[NOPS - 1]);
+		if (local > 0)
+		{
+			benchmark_record("kvstore", variant, i, "client.throughput",
+				((uint64_t) NOPS*BENCHMARK_TIMER_FREQ)/local,
+				BENCHMARK_UNIT_OPS
+			);
+		}
+
+		if ((me == 0) && (elapsed > 0))
+		{
+			benchmark_record("kvstore", variant, i, "throughput",
+				((uint64_t) nclients*NOPS*BENCHMARK_TIMER_FREQ)/elapsed,
+				BENCHMARK_UNIT_OPS
+			);
+		}
+	}
+}
+
+/**
+ * @brief Benchmarks a key-value store in remote memory.
+ */
+static void benchmark_app_kvstore(void)
+{
+	uint64_t t0, t1;
+
+	/* Build list of nodes. */
+	for (int i = 0; i < NANVIX_PROC_MAX; i++)
+		nodes[i] = PROCESSOR_NODENUM_LEADER + i;
+
+	barrier = barrier_create(nodes, NANVIX_PROC_MAX);
+	uassert(BARRIER_IS_VALID(barrier));
+
+	/*
+	 * Each cluster owns a store. Remote caches are not coherent, so
+	 * stores are not shared, but all of them contend for the same
+	 * remote memory servers.
+	 */
+	for (int i = 0; i < INDEX_BLOCKS; i++)
+		uassert((index_blocks[i] = nanvix_vmem_alloc(1)) != NULL);
+	for (int i = 0; i < SLAB_BLOCKS; i++)
+		uassert((slab_blocks[i] = nanvix_vmem_alloc(1)) != NULL);
+
+	zipf_init();
+
+	kclock(&t0);
+		kv_load();
+	kclock(&t1);
+
+	benchmark_record_time("kvstore", "kvstore:load", 0, "time", benchmark_elapsed(t0, t1));
+
+		for (int nclients = 1; nclients <= NANVIX_PROC_MAX; nclients *= 2)
+		{
+			for (size_t w = 0; w < sizeof(workloads)/sizeof(workloads[0]); w++)
+				benchmark_kvstore(&workloads[w], nclients);
+		}
+
+	/* House keeping. */
+	for (int i = SLAB_BLOCKS - 1; i >= 0; i--)
+		uassert(nanvix_vmem_free(slab_blocks[i]) == 0);
+	for (int i = INDEX_BLOCKS - 1; i >= 0; i--)
+		uassert(nanvix_vmem_free(index_blocks[i]) == 0);
+
+	uassert(barrier_destroy(barrier) == 0);
+}
+
+/*============================================================================*
+ * Benchmark Driver                                                           *
+ *============================================================================*/
+
+/**
+ * @brief Launches a benchmark.
+ */
+int __main3(int argc, const char *argv[])
+{
+	((void) argc);
+	((void) argv);
+
+	benchmark_calibrate();
+
+	benchmark_app_kvstore();
+
+	return (0);
+}
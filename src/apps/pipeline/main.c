@@ -0,0 +1,425 @@
+/*
+ * MIT License
+ *
+ * Copyright(c) 2011-2020 The Maintainers of Nanvix
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <nanvix/runtime/runtime.h>
+#include <nanvix/runtime/barrier.h>
+#include <nanvix/sys/perf.h>
+#include <nanvix/limits.h>
+#include <nanvix/ulib.h>
+#include <benchmark/record.h>
+#include <benchmark/units.h>
+#include <benchmark/calibration.h>
+
+/**
+ * @brief Number of iterations for the benchmark.
+ */
+#ifdef NDEBUG
+#define NITERATIONS 30
+#else
+#define NITERATIONS 1
+#endif
+
+static barrier_t barrier;
+static int nodes[NANVIX_PROC_MAX];
+
+/*============================================================================*
+ * Benchmark Kernel                                                           *
+ *============================================================================*/
+
+/**
+ * @brief Number of chunks streamed through the pipeline.
+ */
+#ifndef NCHUNKS
+#define NCHUNKS 64
+#endif
+
+/**
+ * @brief Smallest chunk (in bytes).
+ */
+#ifndef CHUNK_MIN
+#define CHUNK_MIN 1024
+#endif
+
+/**
+ * @brief Largest chunk (in bytes).
+ */
+#ifndef CHUNK_MAX
+#define CHUNK_MAX (8*1024)
+#endif
+
+/**
+ * @brief Checksum passes applied by each filter to a chunk.
+ */
+#ifndef COMPUTE_ROUNDS
+#define COMPUTE_ROUNDS 4
+#endif
+
+/**
+ * @brief Port number used by portals.
+ */
+#define PORT_NUM 0
+
+/**
+ * @brief Port number used by mailboxes.
+ */
+#define MAILBOX_PORT 1
+
+/**
+ * @brief Statistics of a stage.
+ */
+struct stage_stats
+{
+	int stage;       /**< Stage number.                 */
+	uint64_t busy;   /**< Cycles spent computing.       */
+	uint64_t wait;   /**< Cycles spent waiting on I/O.  */
+};
+
+/**
+ * @brief Chunk buffers (double buffering).
+ */
+static char buffers[2][CHUNK_MAX];
+
+/**
+ * @brief Checksum of the last chunk (keeps computation alive).
+ */
+static uint32_t checksum;
+
+/**
+ * @brief Statistics of this stage.
+ */
+static struct stage_stats stats;
+
+/**
+ * @brief Output portal is busy?
+ */
+static int pending;
+
+/**
+ * @brief Communication endpoints.
+ */
+/**@{*/
+static int inportal;
+static int outportal;
+static int inbox;
+static int outbox;
+/**@}*/
+
+/**
+ * @brief Applies the compute cost of a stage to a chunk.
+ *
+ * Each pass computes an Adler-like checksum, and the chunk is then
+ * transformed so that the consumer can tell how many filters it crossed.
+ */
+static void chunk_filter(char *chunk, int size)
+{
+	uint32_t a = 1, b = 0;
+
+	for (int r = 0; r < COMPUTE_ROUNDS; r++)
+	{
+		for (int i = 0; i < size; i++)
+		{
+			a = (a + (uint8_t) chunk[i]) % 65521;
+			b = (b + a) % 65521;
+		}
+	}
+
+	checksum = (b << 16) | a;
+
+	for (int i = 0; i < size; i++)
+		chunk[i]++;
+}
+
+/**
+ * @brief Waits for I/O on a portal.
+ */
+static void stage_wait(int portal)
+{
+	uint64_t t0, t1;
+
+	kclock(&t0);
+		uassert(kportal_wait(portal) == 0);
+	kclock(&t1);
+
+	stats.wait += benchmark_elapsed(t0, t1);
+}
+
+/**
+ * @brief Forwards a chunk to the next stage.
+ */
+static void stage_send(const char *chunk, int size)
+{
+	if (pending)
+		stage_wait(outportal);
+
+	uassert(kportal_awrite(outportal, chunk, size) == (ssize_t) size);
+	pending = 1;
+}
+
+/**
+ * @brief Posts the receive of a chunk from the previous stage.
+ */
+static void stage_post(char *chunk, int size)
+{
+	uassert(kportal_allow(inportal, knode_get_num() - 1, PORT_NUM) == 0);
+	uassert(kportal_aread(inportal, chunk, size) == (ssize_t) size);
+}
+
+/**
+ * @brief Runs the producer.
+ */
+static void do_producer(int size)
+{
+	uint64_t t0, t1;
+	char *chunk;
+
+	for (int k = 0; k < NCHUNKS; k++)
+	{
+		/* The buffer was sent two chunks ago, so it is free. */
+		chunk = buffers[k%2];
+
+		kclock(&t0);
+			for (int i = 0; i < size; i++)
+				chunk[i] = (char) (k + i);
+		kclock(&t1);
+		stats.busy += benchmark_elapsed(t0, t1);
+
+		stage_send(chunk, size);
+	}
+}
+
+/**
+ * @brief Runs a filter.
+ */
+static void do_filter(int size)
+{
+	uint64_t t0, t1;
+	char *chunk;
+
+	stage_post(buffers[0], size);
+
+	for (int k = 0; k < NCHUNKS; k++)
+	{
+		chunk = buffers[k%2];
+
+		stage_wait(inportal);
+
+		/* Receive next chunk into the other buffer, once it is sent. */
+		if (k + 1 < NCHUNKS)
+		{
+			if (pending)
+			{
+				stage_wait(outportal);
+				pending = 0;
+			}
+
+			stage_post(buffers[(k + 1)%2], size);
+		}
+
+		kclock(&t0);
+			chunk_filter(chunk, size);
+		kclock(&t1);
+		stats.busy += benchmark_elapsed(t0, t1);
+
+		stage_send(chunk, size);
+	}
+}
+
+/**
+ * @brief Runs the consumer.
+ */
+static void do_consumer(int size, int nfilters)
+{
+	uint64_t t0, t1;
+	char *chunk;
+
+	stage_post(buffers[0], size);
+
+	for (int k = 0; k < NCHUNKS; k++)
+	{
+		chunk = buffers[k%2];
+
+		stage_wait(inportal);
+
+		if (k + 1 < NCHUNKS)
+			stage_post(buffers[(k + 1)%2], size);
+
+		kclock(&t0);
+			for (int i = 0; i < size; i++)
+				uassert(chunk[i] == (char) (k + i + nfilters));
+		kclock(&t1);
+		stats.busy += benchmark_elapsed(t0, t1);
+	}
+}
+
+/**
+ * @brief Streams chunks through a pipeline.
+ *
+ * @param nstages Number of stages.
+ * @param size    Chunk size (in bytes).
+ */
+static void benchmark_pipeline(int nstages, int size)
+{
+	int me;
+	uint64_t t0, t1, elapsed;
+	uint64_t maxbusy;
+	int bottleneck;
+	char msg[KMAILBOX_MESSAGE_SIZE];
+	struct stage_stats remote;
+	char variant[BENCHMARK_VARIANT_MAX];
+
+	me = knode_get_num() - PROCESSOR_NODENUM_LEADER;
+
+	usprintf(variant, "pipeline:stages=%d,chunk=%d,rounds=%d", nstages, size, COMPUTE_ROUNDS);
+
+	for (int i = 1; i <= NITERATIONS; i++)
+	{
+		umemset(&stats, 0, sizeof(stats));
+		stats.stage = me;
+		pending = 0;
+
+		uassert(barrier_wait(barrier) == 0);
+		kclock(&t0);
+
+			if (me == 0)
+				do_producer(size);
+			else if (me < nstages - 1)
+				do_filter(size);
+			else if (me == nstages - 1)
+				do_consumer(size, nstages - 2);
+
+			if (pending)
+				stage_wait(outportal);
+
+		uassert(barrier_wait(barrier) == 0);
+		kclock(&t1);
+		elapsed = benchmark_elapsed(t0, t1);
+
+		if (me >= nstages)
+			continue;
+
+		/* Dump statistics. */
+		benchmark_record_time("pipeline", variant, i, "busy", stats.busy);
+		benchmark_record_time("pipeline", variant, i, "wait", stats.wait);
+		if (elapsed > 0)
+			benchmark_record("pipeline", variant, i, "utilization", (stats.busy*1000)/elapsed, BENCHMARK_UNIT_MILLI);
+
+		/* Find the bottleneck, at the leader. */
+		if (me == 0)
+		{
+			bottleneck = 0;
+			maxbusy = stats.busy;
+
+			for (int j = 1; j < nstages; j++)
+			{
+				uassert(kmailbox_read(inbox, msg, KMAILBOX_MESSAGE_SIZE) == KMAILBOX_MESSAGE_SIZE);
+				umemcpy(&remote, msg, sizeof(remote));
+
+				if (remote.busy > maxbusy)
+				{
+					maxbusy = remote.busy;
+					bottleneck = remote.stage;
+				}
+			}
+
+			benchmark_record("pipeline", variant, i, "bottleneck", bottleneck, BENCHMARK_UNIT_COUNT);
+			benchmark_record_time("pipeline", variant, i, "bottleneck.busy", maxbusy);
+			benchmark_record_time("pipeline", variant, i, "time", elapsed);
+			benchmark_record_bandwidth("pipeline", variant, i, "throughput", (uint64_t) NCHUNKS*size, elapsed);
+		}
+		else
+		{
+			umemset(msg, 0, sizeof(msg));
+			umemcpy(msg, &stats, sizeof(stats));
+			uassert(kmailbox_write(outbox, msg, KMAILBOX_MESSAGE_SIZE) == KMAILBOX_MESSAGE_SIZE);
+		}
+	}
+}
+
+/**
+ * @brief Benchmarks a streaming pipeline.
+ */
+static void benchmark_app_pipeline(void)
+{
+	int me;
+
+	me = knode_get_num() - PROCESSOR_NODENUM_LEADER;
+
+	/* Build list of nodes. */
+	for (int i = 0; i < NANVIX_PROC_MAX; i++)
+		nodes[i] = PROCESSOR_NODENUM_LEADER + i;
+
+	barrier = barrier_create(nodes, NANVIX_PROC_MAX);
+	uassert(BARRIER_IS_VALID(barrier));
+
+	/* Chain stages. */
+	if (me > 0)
+	{
+		uassert((inportal = kportal_create(knode_get_num(), PORT_NUM)) >= 0);
+		uassert((outbox = kmailbox_open(PROCESSOR_NODENUM_LEADER, MAILBOX_PORT)) >= 0);
+	}
+	else
+		uassert((inbox = kmailbox_create(knode_get_num(), MAILBOX_PORT)) >= 0);
+	if (me < NANVIX_PROC_MAX - 1)
+		uassert((outportal = kportal_open(knode_get_num(), knode_get_num() + 1, PORT_NUM)) >= 0);
+
+	uassert(barrier_wait(barrier) == 0);
+
+		for (int nstages = 2; nstages <= NANVIX_PROC_MAX; nstages *= 2)
+		{
+			for (int size = CHUNK_MIN; size <= CHUNK_MAX; size *= 2)
+				benchmark_pipeline(nstages, size);
+		}
+
+	/* House keeping. */
+	if (me < NANVIX_PROC_MAX - 1)
+		uassert(kportal_close(outportal) == 0);
+	if (me > 0)
+	{
+		uassert(kmailbox_close(outbox) == 0);
+		uassert(kportal_unlink(inportal) == 0);
+	}
+	else
+		uassert(kmailbox_unlink(inbox) == 0);
+
+	uassert(barrier_destroy(barrier) == 0);
+}
+
+/*============================================================================*
+ * Benchmark Driver                                                           *
+ *============================================================================*/
+
+/**
+ * @brief Launches a benchmark.
+ */
+int __main3(int argc, const char *argv[])
+{
+	((void) argc);
+	((void) argv);
+
+	benchmark_calibrate();
+
+	benchmark_app_pipeline();
+
+	return (0);
+}
@@ -0,0 +1,515 @@
+/*
+ * MIT License
+ *
+ * Copyright(c) 2011-2020 The Maintainers of Nanvix
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <nanvix/runtime/runtime.h>
+#include <nanvix/runtime/barrier.h>
+#include <nanvix/sys/perf.h>
+#include <nanvix/limits.h>
+#include <nanvix/ulib.h>
+#include <benchmark/record.h>
+#include <benchmark/units.h>
+#include <benchmark/calibration.h>
+
+/**
+ * @brief Number of iterations for the benchmark.
+ */
+#ifdef NDEBUG
+#define NITERATIONS 30
+#else
+#define NITERATIONS 1
+#endif
+
+static barrier_t barrier;
+static int nodes[NANVIX_PROC_MAX];
+
+/*============================================================================*
+ * Benchmark Kernel                                                           *
+ *============================================================================*/
+
+/**
+ * @brief Smallest number of keys per node.
+ */
+#ifndef NKEYS_MIN
+#define NKEYS_MIN 1024
+#endif
+
+/**
+ * @brief Local memory available for keys (in bytes).
+ *
+ * Compute clusters of the MPPA-256 have 2 MB of local memory, about half
+ * of which is taken by the kernel, the runtime, stacks and the
+ * communication buffers of the runtime.
+ */
+#ifndef SORT_MEMORY
+#define SORT_MEMORY (1024*1024)
+#endif
+
+/**
+ * @brief Largest number of keys per node.
+ *
+ * Each node holds seven times this many keys (its keys, twice as many
+ * for scratch, received buckets and merged output), so the largest
+ * size fills SORT_MEMORY.
+ */
+#ifndef NKEYS_MAX
+#define NKEYS_MAX ((int) (SORT_MEMORY/(7*sizeof(uint32_t))))
+#endif
+
+/**
+ * @brief Maximum number of keys that a node may receive.
+ *
+ * Regular sampling guarantees that no node receives more than twice
+ * the keys of a node.
+ */
+#define NKEYS_RECV_MAX (2*NKEYS_MAX)
+
+/**
+ * @brief Port number used by portals.
+ */
+#define PORT_NUM 0
+
+/**
+ * @brief Port number used by mailboxes.
+ */
+#define MAILBOX_PORT 1
+
+/**
+ * @name Phases
+ */
+/**@{*/
+#define PHASE_SORT      0 /**< Local sort.             */
+#define PHASE_SPLITTERS 1 /**< Splitter selection.     */
+#define PHASE_COUNTS    2 /**< Bucket count exchange.  */
+#define PHASE_EXCHANGE  3 /**< All-to-all exchange.    */
+#define PHASE_MERGE     4 /**< Final merge.            */
+#define PHASES_NUM      5 /**< Number of phases.       */
+/**@}*/
+
+/**
+ * @brief Names of phases.
+ */
+static const char *phases[PHASES_NUM] = {
+	"sort", "splitters", "counts", "exchange", "merge"
+};
+
+/**
+ * @brief Keys.
+ */
+/**@{*/
+static uint32_t keys[NKEYS_MAX];             /**< Local keys.            */
+static uint32_t scratch[NKEYS_RECV_MAX];     /**< Scratch for sorting.   */
+static uint32_t received[NKEYS_RECV_MAX];    /**< Received buckets.      */
+static uint32_t sorted[NKEYS_RECV_MAX];      /**< Output.                */
+/**@}*/
+
+/**
+ * @brief Samples and splitters.
+ */
+/**@{*/
+static uint32_t samples[NANVIX_PROC_MAX*NANVIX_PROC_MAX];
+static uint32_t splitters[NANVIX_PROC_MAX];
+/**@}*/
+
+/**
+ * @brief Buckets.
+ */
+/**@{*/
+static int sendoff[NANVIX_PROC_MAX + 1]; /**< Offset of each outgoing bucket.  */
+static int recvcnt[NANVIX_PROC_MAX];     /**< Size of each incoming bucket.    */
+static int recvoff[NANVIX_PROC_MAX + 1]; /**< Offset of each incoming bucket.  */
+/**@}*/
+
+/**
+ * @brief Communication endpoints.
+ */
+/**@{*/
+static int inportal;
+static int outportals[NANVIX_PROC_MAX];
+static int inbox;
+static int outboxes[NANVIX_PROC_MAX];
+/**@}*/
+
+/**
+ * @brief Generates keys.
+ *
+ * Keys are drawn from a linear congruential generator seeded by the
+ * node index and iteration, so runs are reproducible.
+ */
+static void keys_generate(int me, int iteration, int nkeys)
+{
+	uint32_t x;
+
+	x = 0x9e3779b9u*((uint32_t) me + 1) + (uint32_t) iteration;
+
+	for (int i = 0; i < nkeys; i++)
+	{
+		x = x*1664525u + 1013904223u;
+		keys[i] = x;
+	}
+}
+
+/**
+ * @brief Sorts keys with a least-significant-digit radix sort.
+ *
+ * @param a   Keys.
+ * @param tmp Scratch buffer, as large as @p a.
+ * @param n   Number of keys.
+ */
+static void radix_sort(uint32_t *a, uint32_t *tmp, int n)
+{
+	int count[256];
+	uint32_t *src = a;
+	uint32_t *dst = tmp;
+	uint32_t *swap;
+
+	for (int shift = 0; shift < 32; shift += 8)
+	{
+		umemset(count, 0, sizeof(count));
+
+		for (int i = 0; i < n; i++)
+			count[(src[i] >> shift) & 0xff]++;
+
+		for (int d = 0, sum = 0; d < 256; d++)
+		{
+			int c = count[d];
+			count[d] = sum;
+			sum += c;
+		}
+
+		for (int i = 0; i < n; i++)
+			dst[count[(src[i] >> shift) & 0xff]++] = src[i];
+
+		swap = src;
+		src = dst;
+		dst = swap;
+	}
+
+	/* An even number of passes leaves keys in place. */
+}
+
+/**
+ * @brief Selects splitters.
+ *
+ * Every node sends regular samples of its sorted keys to the leader,
+ * which sorts them and broadcasts P - 1 splitters back.
+ */
+static void select_splitters(int me, int nkeys)
+{
+	int nnodes = NANVIX_PROC_MAX;
+	size_t size = nnodes*sizeof(uint32_t);
+
+	for (int i = 0; i < nnodes; i++)
+		samples[me*nnodes + i] = keys[(i*nkeys)/nnodes];
+
+	if (me == 0)
+	{
+		for (int i = 1; i < nnodes; i++)
+		{
+			uassert(kportal_allow(inportal, PROCESSOR_NODENUM_LEADER + i, PORT_NUM) == 0);
+			uassert(kportal_read(inportal, &samples[i*nnodes], size) == (ssize_t) size);
+		}
+
+		radix_sort(samples, scratch, nnodes*nnodes);
+
+		for (int i = 1; i < nnodes; i++)
+			splitters[i - 1] = samples[i*nnodes + nnodes/2];
+
+		for (int i = 1; i < nnodes; i++)
+			uassert(kportal_write(outportals[i], splitters, size) == (ssize_t) size);
+	}
+	else
+	{
+		uassert(kportal_write(outportals[0], &samples[me*nnodes], size) == (ssize_t) size);
+		uassert(kportal_allow(inportal, PROCESSOR_NODENUM_LEADER, PORT_NUM) == 0);
+		uassert(kportal_read(inportal, splitters, size) == (ssize_t) size);
+	}
+}
+
+/**
+ * @brief Partitions sorted keys into buckets and exchanges bucket sizes.
+ *
+ * Bucket sizes are small, so they go through mailboxes.
+ */
+static void exchange_counts(int me, int nkeys)
+{
+	int lo, hi, mid;
+	int nnodes = NANVIX_PROC_MAX;
+	int msg[KMAILBOX_MESSAGE_SIZE/sizeof(int)];
+
+	/* Bucket i holds keys in [splitters[i - 1], splitters[i]). */
+	sendoff[0] = 0;
+	for (int i = 0; i < (nnodes - 1); i++)
+	{
+		lo = sendoff[i];
+		hi = nkeys;
+		while (lo < hi)
+		{
+			mid = (lo + hi)/2;
+			if (keys[mid] < splitters[i])
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		sendoff[i + 1] = lo;
+	}
+	sendoff[nnodes] = nkeys;
+
+	umemset(msg, 0, sizeof(msg));
+	for (int i = 0; i < nnodes; i++)
+	{
+		if (i == me)
+			continue;
+
+		msg[0] = me;
+		msg[1] = sendoff[i + 1] - sendoff[i];
+		uassert(kmailbox_write(outboxes[i], msg, KMAILBOX_MESSAGE_SIZE) == KMAILBOX_MESSAGE_SIZE);
+	}
+
+	recvcnt[me] = sendoff[me + 1] - sendoff[me];
+	for (int i = 1; i < nnodes; i++)
+	{
+		uassert(kmailbox_read(inbox, msg, KMAILBOX_MESSAGE_SIZE) == KMAILBOX_MESSAGE_SIZE);
+		recvcnt[msg[0]] = msg[1];
+	}
+
+	recvoff[0] = 0;
+	for (int i = 0; i < nnodes; i++)
+		recvoff[i + 1] = recvoff[i] + recvcnt[i];
+
+	uassert(recvoff[nnodes] <= NKEYS_RECV_MAX);
+}
+
+/**
+ * @brief Exchanges buckets.
+ *
+ * At step s, each node sends to the node s positions ahead and receives
+ * from the node s positions behind, so every pair exchanges once.
+ */
+static void exchange_buckets(int me)
+{
+	int to, from;
+	int nnodes = NANVIX_PROC_MAX;
+	size_t sendsize, recvsize;
+
+	umemcpy(&received[recvoff[me]], &keys[sendoff[me]], recvcnt[me]*sizeof(uint32_t));
+
+	for (int s = 1; s < nnodes; s++)
+	{
+		to = (me + s) % nnodes;
+		from = (me - s + nnodes) % nnodes;
+
+		sendsize = (sendoff[to + 1] - sendoff[to])*sizeof(uint32_t);
+		recvsize = recvcnt[from]*sizeof(uint32_t);
+
+		if (sendsize > 0)
+			uassert(kportal_awrite(outportals[to], &keys[sendoff[to]], sendsize) == (ssize_t) sendsize);
+
+		if (recvsize > 0)
+		{
+			uassert(kportal_allow(inportal, PROCESSOR_NODENUM_LEADER + from, PORT_NUM) == 0);
+			uassert(kportal_read(inportal, &received[recvoff[from]], recvsize) == (ssize_t) recvsize);
+		}
+
+		if (sendsize > 0)
+			uassert(kportal_wait(outportals[to]) == 0);
+	}
+}
+
+/**
+ * @brief Merges received buckets.
+ *
+ * Buckets are sorted runs, and there are only a few of them, so the
+ * smallest head is found with a linear scan.
+ *
+ * @returns The number of merged keys.
+ */
+static int merge_buckets(void)
+{
+	int n = 0;
+	int best;
+	int nnodes = NANVIX_PROC_MAX;
+	int heads[NANVIX_PROC_MAX];
+
+	for (int i = 0; i < nnodes; i++)
+		heads[i] = recvoff[i];
+
+	while (n < recvoff[nnodes])
+	{
+		best = -1;
+		for (int i = 0; i < nnodes; i++)
+		{
+			if (heads[i] == recvoff[i + 1])
+				continue;
+
+			if ((best < 0) || (received[heads[i]] < received[heads[best]]))
+				best = i;
+		}
+
+		sorted[n++] = received[heads[best]++];
+	}
+
+	return (n);
+}
+
+/**
+ * @brief Checks the output.
+ */
+static void check_sorted(int me, int n)
+{
+	for (int i = 1; i < n; i++)
+		uassert(sorted[i - 1] <= sorted[i]);
+
+	if (n > 0)
+	{
+		if (me > 0)
+			uassert(sorted[0] >= splitters[me - 1]);
+		if (me < (NANVIX_PROC_MAX - 1))
+			uassert(sorted[n - 1] < splitters[me]);
+	}
+}
+
+/**
+ * @brief Sorts a dataset.
+ *
+ * @param nkeys Number of keys per node.
+ */
+static void benchmark_sort(int nkeys)
+{
+	int me;
+	int n;
+	uint64_t t0, t1;
+	uint64_t marks[PHASES_NUM + 1];
+	char variant[BENCHMARK_VARIANT_MAX];
+
+	me = knode_get_num() - PROCESSOR_NODENUM_LEADER;
+
+	usprintf(variant, "sort:keys=%d,nodes=%d", nkeys, NANVIX_PROC_MAX);
+
+	for (int i = 1; i <= NITERATIONS; i++)
+	{
+		keys_generate(me, i, nkeys);
+
+		uassert(barrier_wait(barrier) == 0);
+		kclock(&t0);
+
+			kclock(&marks[PHASE_SORT]);
+			radix_sort(keys, scratch, nkeys);
+			kclock(&marks[PHASE_SPLITTERS]);
+			select_splitters(me, nkeys);
+			kclock(&marks[PHASE_COUNTS]);
+			exchange_counts(me, nkeys);
+			kclock(&marks[PHASE_EXCHANGE]);
+			exchange_buckets(me);
+			kclock(&marks[PHASE_MERGE]);
+			n = merge_buckets();
+			kclock(&marks[PHASES_NUM]);
+
+		uassert(barrier_wait(barrier) == 0);
+		kclock(&t1);
+
+		check_sorted(me, n);
+
+		/* Dump statistics. */
+		for (int p = 0; p < PHASES_NUM; p++)
+			benchmark_record_time("sort", variant, i, phases[p], benchmark_elapsed(marks[p], marks[p + 1]));
+		benchmark_record_time("sort", variant, i, "total", benchmark_elapsed(marks[0], marks[PHASES_NUM]));
+		benchmark_record("sort", variant, i, "keys", n, BENCHMARK_UNIT_COUNT);
+
+		if ((me == 0) && (benchmark_elapsed(t0, t1) > 0))
+		{
+			benchmark_record("sort", variant, i, "throughput",
+				(((uint64_t) nkeys)*NANVIX_PROC_MAX*BENCHMARK_TIMER_FREQ)/benchmark_elapsed(t0, t1),
+				BENCHMARK_UNIT_KEYS
+			);
+		}
+	}
+}
+
+/**
+ * @brief Benchmarks a distributed integer sort.
+ */
+static void benchmark_app_sort(void)
+{
+	int me;
+
+	me = knode_get_num() - PROCESSOR_NODENUM_LEADER;
+
+	/* Build list of nodes. */
+	for (int i = 0; i < NANVIX_PROC_MAX; i++)
+		nodes[i] = PROCESSOR_NODENUM_LEADER + i;
+
+	barrier = barrier_create(nodes, NANVIX_PROC_MAX);
+	uassert(BARRIER_IS_VALID(barrier));
+
+	/* Establish connections. */
+	uassert((inportal = kportal_create(knode_get_num(), PORT_NUM)) >= 0);
+	uassert((inbox = kmailbox_create(knode_get_num(), MAILBOX_PORT)) >= 0);
+	for (int i = 0; i < NANVIX_PROC_MAX; i++)
+	{
+		if (i == me)
+			continue;
+
+		uassert((outportals[i] = kportal_open(knode_get_num(), nodes[i], PORT_NUM)) >= 0);
+		uassert((outboxes[i] = kmailbox_open(nodes[i], MAILBOX_PORT)) >= 0);
+	}
+
+	uassert(barrier_wait(barrier) == 0);
+
+		for (int nkeys = NKEYS_MIN; nkeys < NKEYS_MAX; nkeys *= 2)
+			benchmark_sort(nkeys);
+		benchmark_sort(NKEYS_MAX);
+
+	/* House keeping. */
+	for (int i = 0; i < NANVIX_PROC_MAX; i++)
+	{
+		if (i == me)
+			continue;
+
+		uassert(kmailbox_close(outboxes[i]) == 0);
+		uassert(kportal_close(outportals[i]) == 0);
+	}
+	uassert(kmailbox_unlink(inbox) == 0);
+	uassert(kportal_unlink(inportal) == 0);
+
+	uassert(barrier_destroy(barrier) == 0);
+}
+
+/*============================================================================*
+ * Benchmark Driver                                                           *
+ *============================================================================*/
+
+/**
+ * @brief Launches a benchmark.
+ */
+int __main3(int argc, const char *argv[])
+{
+	((void) argc);
+	((void) argv);
+
+	benchmark_calibrate();
+
+	benchmark_app_sort();
+
+	return (0);
+}
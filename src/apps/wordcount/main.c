@@ -0,0 +1,552 @@
+/*
+ * MIT License
+ *
+ * Copyright(c) 2011-2020 The Maintainers of Nanvix
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <nanvix/runtime/runtime.h>
+#include <nanvix/runtime/barrier.h>
+#include <nanvix/sys/perf.h>
+#include <nanvix/limits.h>
+#include <nanvix/ulib.h>
+#include <benchmark/record.h>
+#include <benchmark/units.h>
+#include <benchmark/calibration.h>
+
+/**
+ * @brief Number of iterations for the benchmark.
+ */
+#ifdef NDEBUG
+#define NITERATIONS 30
+#else
+#define NITERATIONS 1
+#endif
+
+static barrier_t barrier;
+static int nodes[NANVIX_PROC_MAX];
+
+/*============================================================================*
+ * Benchmark Kernel                                                           *
+ *============================================================================*/
+
+/**
+ * @brief Size of the text of each mapper (in bytes).
+ */
+#ifndef TEXT_SIZE
+#define TEXT_SIZE (32*1024)
+#endif
+
+/**
+ * @brief Number of distinct words.
+ */
+#ifndef VOCABULARY_SIZE
+#define VOCABULARY_SIZE 1024
+#endif
+
+/**
+ * @brief Smallest batch (in records).
+ */
+#ifndef BATCH_MIN
+#define BATCH_MIN 16
+#endif
+
+/**
+ * @brief Largest batch (in records).
+ */
+#ifndef BATCH_MAX
+#define BATCH_MAX 256
+#endif
+
+/**
+ * @brief Number of slots in the hash table of a reducer (power of two).
+ */
+#ifndef TABLE_SIZE
+#define TABLE_SIZE 4096
+#endif
+
+/**
+ * @brief Maximum length of a word, including the terminating null.
+ */
+#define WORD_MAX 12
+
+/**
+ * @brief Number of mappers (the remaining nodes are reducers).
+ */
+#define NMAPPERS (NANVIX_PROC_MAX/2)
+
+/**
+ * @brief Number of reducers.
+ */
+#define NREDUCERS (NANVIX_PROC_MAX - NMAPPERS)
+
+/**
+ * @brief Port number used by portals.
+ */
+#define PORT_NUM 0
+
+/**
+ * @brief Port number used by mailboxes.
+ */
+#define MAILBOX_PORT 1
+
+/**
+ * @name Types of messages.
+ */
+/**@{*/
+#define MSG_BATCH   0 /**< A batch follows (empty batch ends a stream). */
+#define MSG_MAPPED  1 /**< Records emitted by a mapper.                 */
+#define MSG_REDUCED 2 /**< Records aggregated by a reducer.             */
+/**@}*/
+
+/**
+ * @brief Record.
+ */
+struct record
+{
+	char word[WORD_MAX]; /**< Word.  */
+	uint32_t count;      /**< Count. */
+};
+
+/**
+ * @brief Slot of a hash table.
+ */
+struct slot
+{
+	uint32_t hash;       /**< Hash of the word (zero if empty). */
+	struct record rec;   /**< Aggregated record.                */
+};
+
+/**
+ * @brief Text of a mapper.
+ */
+static char text[TEXT_SIZE];
+
+/**
+ * @brief Outgoing batches of a mapper, one per reducer.
+ */
+/**@{*/
+static struct record batches[NREDUCERS][BATCH_MAX];
+static int batchlen[NREDUCERS];
+/**@}*/
+
+/**
+ * @brief Incoming batch of a reducer.
+ */
+static struct record incoming[BATCH_MAX];
+
+/**
+ * @brief Hash table of a reducer.
+ */
+static struct slot table[TABLE_SIZE];
+
+/**
+ * @brief Statistics of a node.
+ */
+static struct
+{
+	uint64_t records; /**< Records emitted or aggregated. */
+	uint64_t flushes; /**< Batches sent or received.      */
+	uint64_t unique;  /**< Distinct words (reducers).     */
+} stats;
+
+/**
+ * @brief Communication endpoints.
+ */
+/**@{*/
+static int inportal;
+static int outportals[NANVIX_PROC_MAX];
+static int inbox;
+static int outboxes[NANVIX_PROC_MAX];
+/**@}*/
+
+/**
+ * @brief Hashes a word (FNV-1a).
+ */
+static uint32_t word_hash(const char *word)
+{
+	uint32_t h = 2166136261u;
+
+	while (*word != '\0')
+	{
+		h ^= (uint8_t) *word++;
+		h *= 16777619u;
+	}
+
+	/* Zero marks empty slots. */
+	return ((h == 0) ? 1 : h);
+}
+
+/**
+ * @brief Generates synthetic text.
+ *
+ * Words are drawn from a skewed distribution over the vocabulary (low
+ * identifiers are more frequent), and spelled in base 26.
+ */
+static void text_generate(int me, int iteration)
+{
+	int n = 0;
+	uint32_t x, id, r;
+
+	x = 0x9e3779b9u*((uint32_t) me + 1) + (uint32_t) iteration;
+
+	while (n < (TEXT_SIZE - WORD_MAX))
+	{
+		x = x*1664525u + 1013904223u;
+		r = (x >> 16) % VOCABULARY_SIZE;
+		id = (r*r)/VOCABULARY_SIZE;
+
+		do
+		{
+			text[n++] = 'a' + (id % 26);
+			id /= 26;
+		} while (id > 0);
+
+		text[n++] = ' ';
+	}
+
+	while (n < TEXT_SIZE)
+		text[n++] = ' ';
+}
+
+/**
+ * @brief Sends a message to a node.
+ */
+static void message_send(int to, int type, int value)
+{
+	int msg[KMAILBOX_MESSAGE_SIZE/sizeof(int)];
+
+	umemset(msg, 0, sizeof(msg));
+	msg[0] = type;
+	msg[1] = knode_get_num() - PROCESSOR_NODENUM_LEADER;
+	msg[2] = value;
+
+	uassert(kmailbox_write(outboxes[to], msg, KMAILBOX_MESSAGE_SIZE) == KMAILBOX_MESSAGE_SIZE);
+}
+
+/**
+ * @brief Receives a message.
+ */
+static void message_recv(int *type, int *from, int *value)
+{
+	int msg[KMAILBOX_MESSAGE_SIZE/sizeof(int)];
+
+	uassert(kmailbox_read(inbox, msg, KMAILBOX_MESSAGE_SIZE) == KMAILBOX_MESSAGE_SIZE);
+
+	*type = msg[0];
+	*from = msg[1];
+	*value = msg[2];
+}
+
+/**
+ * @brief Flushes the batch of a reducer.
+ *
+ * The reducer is notified through its mailbox, and the batch follows
+ * through its portal.
+ */
+static void batch_flush(int r)
+{
+	int to = NMAPPERS + r;
+	size_t size = batchlen[r]*sizeof(struct record);
+
+	message_send(to, MSG_BATCH, batchlen[r]);
+
+	if (batchlen[r] > 0)
+	{
+		uassert(kportal_write(outportals[to], batches[r], size) == (ssize_t) size);
+		stats.flushes++;
+	}
+
+	batchlen[r] = 0;
+}
+
+/**
+ * @brief Tokenizes text and streams records to reducers.
+ */
+static void do_mapper(int batch)
+{
+	int len;
+	int r;
+	uint32_t h;
+	struct record *rec;
+
+	for (int i = 0; i < NREDUCERS; i++)
+		batchlen[i] = 0;
+
+	for (int i = 0; i < TEXT_SIZE; i += len + 1)
+	{
+		for (len = 0; (i + len < TEXT_SIZE) && (text[i + len] != ' '); len++)
+			/* noop */ ;
+
+		if (len == 0)
+			continue;
+
+		text[i + len] = '\0';
+		h = word_hash(&text[i]);
+		r = h % NREDUCERS;
+
+		rec = &batches[r][batchlen[r]++];
+		umemset(rec->word, 0, WORD_MAX);
+		ustrncpy(rec->word, &text[i], WORD_MAX - 1);
+		rec->count = 1;
+		stats.records++;
+
+		if (batchlen[r] == batch)
+			batch_flush(r);
+	}
+
+	/* Flush what is left, then end streams with empty batches. */
+	for (int i = 0; i < NREDUCERS; i++)
+	{
+		if (batchlen[i] > 0)
+			batch_flush(i);
+		batch_flush(i);
+	}
+}
+
+/**
+ * @brief Aggregates a record into the hash table.
+ */
+static void table_insert(const struct record *rec)
+{
+	uint32_t h;
+	uint32_t i;
+
+	h = word_hash(rec->word);
+
+	for (i = h & (TABLE_SIZE - 1); ; i = (i + 1) & (TABLE_SIZE - 1))
+	{
+		if (table[i].hash == 0)
+		{
+			table[i].hash = h;
+			table[i].rec = *rec;
+			stats.unique++;
+			uassert(stats.unique < TABLE_SIZE);
+			return;
+		}
+
+		if ((table[i].hash == h) && (ustrcmp(table[i].rec.word, rec->word) == 0))
+		{
+			table[i].rec.count += rec->count;
+			return;
+		}
+	}
+}
+
+/**
+ * @brief Receives batches from mappers and aggregates them.
+ */
+static void do_reducer(void)
+{
+	int type, from, n;
+	int nactive = NMAPPERS;
+	size_t size;
+
+	umemset(table, 0, sizeof(table));
+
+	while (nactive > 0)
+	{
+		message_recv(&type, &from, &n);
+		uassert(type == MSG_BATCH);
+
+		if (n == 0)
+		{
+			nactive--;
+			continue;
+		}
+
+		size = n*sizeof(struct record);
+		uassert(kportal_allow(inportal, PROCESSOR_NODENUM_LEADER + from, PORT_NUM) == 0);
+		uassert(kportal_read(inportal, incoming, size) == (ssize_t) size);
+
+		for (int i = 0; i < n; i++)
+			table_insert(&incoming[i]);
+
+		stats.records += n;
+		stats.flushes++;
+	}
+}
+
+/**
+ * @brief Runs a word count.
+ *
+ * @param batch Batch size (in records).
+ */
+static void benchmark_wordcount(int batch)
+{
+	int me;
+	int type, from, value;
+	uint64_t t0, t1, elapsed;
+	uint64_t local0, local1;
+	uint64_t mapped, reduced, maxload;
+	char variant[BENCHMARK_VARIANT_MAX];
+
+	me = knode_get_num() - PROCESSOR_NODENUM_LEADER;
+
+	usprintf(variant, "wordcount:batch=%d,mappers=%d,reducers=%d", batch, NMAPPERS, NREDUCERS);
+
+	for (int i = 1; i <= NITERATIONS; i++)
+	{
+		if (me < NMAPPERS)
+			text_generate(me, i);
+
+		umemset(&stats, 0, sizeof(stats));
+
+		uassert(barrier_wait(barrier) == 0);
+		kclock(&t0);
+
+			kclock(&local0);
+			if (me < NMAPPERS)
+				do_mapper(batch);
+			else
+				do_reducer();
+			kclock(&local1);
+
+		uassert(barrier_wait(barrier) == 0);
+		kclock(&t1);
+		elapsed = benchmark_elapsed(t0, t1);
+
+		/* Dump statistics. */
+		benchmark_record_time("wordcount", variant, i, (me < NMAPPERS) ? "map" : "reduce", benchmark_elapsed(local0, local1));
+		benchmark_record("wordcount", variant, i, "records", stats.records, BENCHMARK_UNIT_COUNT);
+		benchmark_record("wordcount", variant, i, "flushes", stats.flushes, BENCHMARK_UNIT_COUNT);
+		if (stats.flushes > 0)
+		{
+			benchmark_record("wordcount", variant, i, "flush_records", stats.records/stats.flushes, BENCHMARK_UNIT_COUNT);
+			benchmark_record("wordcount", variant, i, "flush_bytes",
+				(stats.records*sizeof(struct record))/stats.flushes,
+				BENCHMARK_UNIT_BYTES
+			);
+		}
+		if (me >= NMAPPERS)
+			benchmark_record("wordcount", variant, i, "unique", stats.unique, BENCHMARK_UNIT_COUNT);
+
+		/* Totals and load of reducers, at the leader. */
+		if (me == 0)
+		{
+			mapped = stats.records;
+			reduced = maxload = 0;
+
+			for (int j = 1; j < NANVIX_PROC_MAX; j++)
+			{
+				message_recv(&type, &from, &value);
+
+				if (type == MSG_MAPPED)
+					mapped += value;
+				else
+				{
+					uassert(type == MSG_REDUCED);
+					reduced += value;
+					maxload = ((uint64_t) value > maxload) ? (uint64_t) value : maxload;
+				}
+			}
+
+			uassert(mapped == reduced);
+
+			if (elapsed > 0)
+			{
+				benchmark_record("wordcount", variant, i, "throughput",
+					(reduced*BENCHMARK_TIMER_FREQ)/elapsed,
+					BENCHMARK_UNIT_RECORDS
+				);
+			}
+
+			/* Largest load over mean load. */
+			if (reduced > 0)
+			{
+				benchmark_record("wordcount", variant, i, "imbalance",
+					(maxload*NREDUCERS*1000)/reduced,
+					BENCHMARK_UNIT_MILLI
+				);
+			}
+		}
+		else
+			message_send(0, (me < NMAPPERS) ? MSG_MAPPED : MSG_REDUCED, (int) stats.records);
+	}
+}
+
+/**
+ * @brief Benchmarks a word count with streaming shuffle.
+ */
+static void benchmark_app_wordcount(void)
+{
+	int me;
+
+	me = knode_get_num() - PROCESSOR_NODENUM_LEADER;
+
+	uassert(NMAPPERS > 0);
+
+	/* Build list of nodes. */
+	for (int i = 0; i < NANVIX_PROC_MAX; i++)
+		nodes[i] = PROCESSOR_NODENUM_LEADER + i;
+
+	barrier = barrier_create(nodes, NANVIX_PROC_MAX);
+	uassert(BARRIER_IS_VALID(barrier));
+
+	/* Establish connections. */
+	uassert((inportal = kportal_create(knode_get_num(), PORT_NUM)) >= 0);
+	uassert((inbox = kmailbox_create(knode_get_num(), MAILBOX_PORT)) >= 0);
+	for (int i = 0; i < NANVIX_PROC_MAX; i++)
+	{
+		if (i == me)
+			continue;
+
+		uassert((outportals[i] = kportal_open(knode_get_num(), nodes[i], PORT_NUM)) >= 0);
+		uassert((outboxes[i] = kmailbox_open(nodes[i], MAILBOX_PORT)) >= 0);
+	}
+
+	uassert(barrier_wait(barrier) == 0);
+
+		for (int batch = BATCH_MIN; batch <= BATCH_MAX; batch *= 4)
+			benchmark_wordcount(batch);
+
+	/* House keeping. */
+	for (int i = 0; i < NANVIX_PROC_MAX; i++)
+	{
+		if (i == me)
+			continue;
+
+		uassert(kmailbox_close(outboxes[i]) == 0);
+		uassert(kportal_close(outportals[i]) == 0);
+	}
+	uassert(kmailbox_unlink(inbox) == 0);
+	uassert(kportal_unlink(inportal) == 0);
+
+	uassert(barrier_destroy(barrier) == 0);
+}
+
+/*============================================================================*
+ * Benchmark Driver                                                           *
+ *============================================================================*/
+
+/**
+ * @brief Launches a benchmark.
+ */
+int __main3(int argc, const char *argv[])
+{
+	((void) argc);
+	((void) argv);
+
+	benchmark_calibrate();
+
+	benchmark_app_wordcount();
+
+	return (0);
+}
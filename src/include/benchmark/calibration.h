@@ -0,0 +1,128 @@
+/*
+ * MIT License
+ *
+ * Copyright(c) 2011-2020 The Maintainers of Nanvix
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BENCHMARK_CALIBRATION_H_
+#define BENCHMARK_CALIBRATION_H_
+
+	#include <nanvix/runtime/runtime.h>
+	#include <nanvix/ulib.h>
+	#include <benchmark/perf.h>
+	#include <benchmark/record.h>
+	#include <benchmark/stats.h>
+	#include <benchmark/units.h>
+
+	/**
+	 * @brief Number of samples taken to calibrate each overhead.
+	 */
+	#ifndef BENCHMARK_CALIBRATION_SAMPLES
+	#define BENCHMARK_CALIBRATION_SAMPLES 256
+	#endif
+
+	/**
+	 * @brief Cycles spent in a call to kclock().
+	 *
+	 * This is set by benchmark_calibrate() and subtracted from intervals
+	 * computed with benchmark_elapsed().
+	 */
+	static uint64_t benchmark_clock_overhead = 0;
+
+	/**
+	 * @brief Computes the time elapsed between two readings of kclock().
+	 *
+	 * @param t0 First reading.
+	 * @param t1 Second reading.
+	 *
+	 * @returns The number of cycles elapsed between @p t0 and @p t1,
+	 * discounting the overhead of reading the clock.
+	 */
+	static inline uint64_t benchmark_elapsed(uint64_t t0, uint64_t t1)
+	{
+		uint64_t dt = t1 - t0;
+
+		return ((dt > benchmark_clock_overhead) ? dt - benchmark_clock_overhead : 0);
+	}
+
+	/**
+	 * @brief Calibrates measurement overheads.
+	 *
+	 * The cost of measuring an empty region and of reading the clock are
+	 * sampled many times, and their medians are reported as "calibration"
+	 * records. They are subtracted from every region measured with
+	 * benchmark_perf_stop() and every interval computed with
+	 * benchmark_elapsed(), respectively. The cost of printing is taken
+	 * from a single line, which names the node being calibrated, and is
+	 * only reported, as no benchmark prints within a measured region.
+	 *
+	 * @note Timings reported by the kernel through ioctl() are not
+	 * affected, as they are measured within the kernel.
+	 */
+	static inline void benchmark_calibrate(void)
+	{
+		uint64_t t0, t1;
+		uint64_t overhead_perf, overhead_clock, overhead_print;
+		struct benchmark_perf perf;
+		static uint64_t samples[BENCHMARK_CALIBRATION_SAMPLES];
+
+		benchmark_perf_overhead = 0;
+		benchmark_clock_overhead = 0;
+
+		/* Empty region. */
+		for (int i = 0; i < BENCHMARK_CALIBRATION_SAMPLES; i++)
+		{
+			benchmark_perf_start(&perf);
+			benchmark_perf_stop(&perf);
+			samples[i] = benchmark_perf_cycles(&perf);
+		}
+		stats_sort(samples, BENCHMARK_CALIBRATION_SAMPLES);
+		overhead_perf = stats_percentile(samples, BENCHMARK_CALIBRATION_SAMPLES, 50);
+
+		/* Clock. */
+		for (int i = 0; i < BENCHMARK_CALIBRATION_SAMPLES; i++)
+		{
+			kclock(&t0);
+			kclock(&t1);
+			samples[i] = t1 - t0;
+		}
+		stats_sort(samples, BENCHMARK_CALIBRATION_SAMPLES);
+		overhead_clock = stats_percentile(samples, BENCHMARK_CALIBRATION_SAMPLES, 50);
+
+		/* Printing. */
+		benchmark_perf_start(&perf);
+		uprintf("calibrating node %d", knode_get_num());
+		benchmark_perf_stop(&perf);
+		overhead_print = benchmark_perf_cycles(&perf);
+
+		benchmark_perf_overhead = overhead_perf;
+		benchmark_clock_overhead = overhead_clock;
+
+		benchmark_record("calibration", "timer", 0, "frequency", BENCHMARK_TIMER_FREQ, BENCHMARK_UNIT_HZ);
+		benchmark_record("calibration", "overhead", 0, "perf", overhead_perf, BENCHMARK_UNIT_CYCLES);
+		benchmark_record("calibration", "overhead", 0, "kclock", overhead_clock, BENCHMARK_UNIT_CYCLES);
+		benchmark_record("calibration", "overhead", 0, "uprintf",
+			(overhead_print > overhead_perf) ? overhead_print - overhead_perf : 0,
+			BENCHMARK_UNIT_CYCLES
+		);
+	}
+
+#endif /* BENCHMARK_CALIBRATION_H_ */
@@ -0,0 +1,213 @@
+/*
+ * MIT License
+ *
+ * Copyright(c) 2011-2020 The Maintainers of Nanvix
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BENCHMARK_NAMECACHE_H_
+#define BENCHMARK_NAMECACHE_H_
+
+	#include <nanvix/runtime/runtime.h>
+	#include <nanvix/limits.h>
+	#include <nanvix/ulib.h>
+	#include <benchmark/units.h>
+
+	/**
+	 * @brief Number of entries in the name cache.
+	 */
+	#ifndef NAME_CACHE_SIZE
+	#define NAME_CACHE_SIZE 32
+	#endif
+
+	/**
+	 * @brief Time to live of a cache entry (in cycles).
+	 */
+	#ifndef NAME_CACHE_TTL
+	#define NAME_CACHE_TTL (BENCHMARK_TIMER_FREQ/10)
+	#endif
+
+	/**
+	 * @brief Number of heartbeats that a cache entry survives.
+	 */
+	#ifndef NAME_CACHE_HEARTBEATS
+	#define NAME_CACHE_HEARTBEATS 1
+	#endif
+
+	/**
+	 * @brief Name cache entry.
+	 */
+	struct name_cache_entry
+	{
+		int valid;                        /**< Valid entry?          */
+		int nodenum;                      /**< Cached node number.   */
+		int epoch;                        /**< Heartbeat epoch.      */
+		uint64_t timestamp;               /**< Time of insertion.    */
+		char name[NANVIX_PROC_NAME_MAX];  /**< Cached name.          */
+	};
+
+	/**
+	 * @brief Client-side name cache.
+	 *
+	 * Entries are dropped when their time to live expires, when more
+	 * than NAME_CACHE_HEARTBEATS heartbeats were issued since they were
+	 * cached and when the cached name is unlinked by this client.
+	 * Bindings that are changed by other clients are seen only after
+	 * expiration, thus NAME_CACHE_TTL bounds staleness.
+	 */
+	static struct
+	{
+		int epoch;                                       /**< Heartbeat epoch.   */
+		uint64_t hits;                                   /**< Number of hits.    */
+		uint64_t misses;                                 /**< Number of misses.  */
+		struct name_cache_entry entries[NAME_CACHE_SIZE];/**< Entries.           */
+	} name_cache;
+
+	/**
+	 * @brief Hashes a name.
+	 *
+	 * @param name Target name.
+	 *
+	 * @returns The slot of @p name in the name cache.
+	 */
+	static inline int name_cache_hash(const char *name)
+	{
+		uint32_t hash = 2166136261u;
+
+		/* FNV-1a. */
+		for (const char *p = name; *p != '\0'; p++)
+		{
+			hash ^= (uint8_t) *p;
+			hash *= 16777619u;
+		}
+
+		return (hash % NAME_CACHE_SIZE);
+	}
+
+	/**
+	 * @brief Asserts whether a cache entry is still fresh.
+	 *
+	 * @param entry Target entry.
+	 * @param now   Current time.
+	 *
+	 * @returns Non-zero if @p entry is fresh and zero otherwise.
+	 */
+	static inline int name_cache_is_fresh(const struct name_cache_entry *entry, uint64_t now)
+	{
+		if (!entry->valid)
+			return (0);
+		if ((now - entry->timestamp) >= NAME_CACHE_TTL)
+			return (0);
+		if ((name_cache.epoch - entry->epoch) > NAME_CACHE_HEARTBEATS)
+			return (0);
+
+		return (1);
+	}
+
+	/**
+	 * @brief Drops all entries of the name cache.
+	 */
+	static inline void name_cache_flush(void)
+	{
+		for (int i = 0; i < NAME_CACHE_SIZE; i++)
+			name_cache.entries[i].valid = 0;
+	}
+
+	/**
+	 * @brief Drops a name from the name cache.
+	 *
+	 * @param name Target name.
+	 */
+	static inline void name_cache_invalidate(const char *name)
+	{
+		struct name_cache_entry *entry;
+
+		entry = &name_cache.entries[name_cache_hash(name)];
+
+		if (entry->valid && (ustrcmp(entry->name, name) == 0))
+			entry->valid = 0;
+	}
+
+	/**
+	 * @brief Looks up a name, going through the name cache.
+	 *
+	 * @param name Target name.
+	 *
+	 * @returns See name_lookup().
+	 */
+	static inline int name_cache_lookup(const char *name)
+	{
+		int nodenum;
+		uint64_t now;
+		struct name_cache_entry *entry;
+
+		kclock(&now);
+		entry = &name_cache.entries[name_cache_hash(name)];
+
+		/* Hit. */
+		if (name_cache_is_fresh(entry, now) && (ustrcmp(entry->name, name) == 0))
+		{
+			name_cache.hits++;
+			return (entry->nodenum);
+		}
+
+		name_cache.misses++;
+
+		/* Negative results are not cached. */
+		if ((nodenum = name_lookup(name)) < 0)
+			return (nodenum);
+
+		ustrncpy(entry->name, name, NANVIX_PROC_NAME_MAX - 1);
+		entry->name[NANVIX_PROC_NAME_MAX - 1] = '\0';
+		entry->nodenum = nodenum;
+		entry->epoch = name_cache.epoch;
+		entry->timestamp = now;
+		entry->valid = 1;
+
+		return (nodenum);
+	}
+
+	/**
+	 * @brief Unlinks a name, keeping the name cache coherent.
+	 *
+	 * @param name Target name.
+	 *
+	 * @returns See name_unlink().
+	 */
+	static inline int name_cache_unlink(const char *name)
+	{
+		name_cache_invalidate(name);
+
+		return (name_unlink(name));
+	}
+
+	/**
+	 * @brief Sends a heartbeat, aging the name cache.
+	 *
+	 * @returns See name_heartbeat().
+	 */
+	static inline int name_cache_heartbeat(void)
+	{
+		name_cache.epoch++;
+
+		return (name_heartbeat());
+	}
+
+#endif /* BENCHMARK_NAMECACHE_H_ */
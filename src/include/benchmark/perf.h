@@ -0,0 +1,325 @@
+/*
+ * MIT License
+ *
+ * Copyright(c) 2011-2020 The Maintainers of Nanvix
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BENCHMARK_PERF_H_
+#define BENCHMARK_PERF_H_
+
+	#include <nanvix/sys/perf.h>
+	#include <nanvix/ulib.h>
+	#include <benchmark/record.h>
+	#include <benchmark/units.h>
+
+	/**
+	 * @brief Number of performance monitors that may be used at once.
+	 */
+	#ifdef PERF_MONITORS_NUM
+	#define BENCHMARK_PERF_MONITORS PERF_MONITORS_NUM
+	#else
+	#define BENCHMARK_PERF_MONITORS 1
+	#endif
+
+	/**
+	 * @name Monitored Events
+	 *
+	 * Events that are not supported by the target are left out. Cycles
+	 * are always counted by the first monitor.
+	 */
+	/**@{*/
+	#define BENCHMARK_PERF_CYCLES 0 /**< Cycles. */
+	#ifdef PERF_BUNDLES
+	#define BENCHMARK_PERF_INSTRUCTIONS_ { PERF_BUNDLES, "instructions", 0 },
+	#else
+	#define BENCHMARK_PERF_INSTRUCTIONS_
+	#endif
+	#ifdef PERF_DCACHE_MISSES
+	#define BENCHMARK_PERF_DCACHE_MISSES_ { PERF_DCACHE_MISSES, "dcache_misses", 1 },
+	#else
+	#define BENCHMARK_PERF_DCACHE_MISSES_
+	#endif
+	#ifdef PERF_ICACHE_MISSES
+	#define BENCHMARK_PERF_ICACHE_MISSES_ { PERF_ICACHE_MISSES, "icache_misses", 1 },
+	#else
+	#define BENCHMARK_PERF_ICACHE_MISSES_
+	#endif
+	#ifdef PERF_BRANCH_STALLS
+	#define BENCHMARK_PERF_BRANCH_STALLS_ { PERF_BRANCH_STALLS, "branch_stalls", 0 },
+	#else
+	#define BENCHMARK_PERF_BRANCH_STALLS_
+	#endif
+	#ifdef PERF_DCACHE_STALLS
+	#define BENCHMARK_PERF_DCACHE_STALLS_ { PERF_DCACHE_STALLS, "dcache_stalls", 0 },
+	#else
+	#define BENCHMARK_PERF_DCACHE_STALLS_
+	#endif
+	#ifdef PERF_REG_STALLS
+	#define BENCHMARK_PERF_REG_STALLS_ { PERF_REG_STALLS, "reg_stalls", 0 },
+	#else
+	#define BENCHMARK_PERF_REG_STALLS_
+	#endif
+	/**@}*/
+
+	/**
+	 * @brief Monitored events.
+	 */
+	static const struct
+	{
+		int event;        /**< Event number.                 */
+		const char *name; /**< Name of the event.            */
+		int per_byte;     /**< Report per byte transferred?  */
+	} benchmark_perf_events[] = {
+		{ PERF_CYCLES, "cycles", 0 },
+		BENCHMARK_PERF_INSTRUCTIONS_
+		BENCHMARK_PERF_DCACHE_MISSES_
+		BENCHMARK_PERF_ICACHE_MISSES_
+		BENCHMARK_PERF_BRANCH_STALLS_
+		BENCHMARK_PERF_DCACHE_STALLS_
+		BENCHMARK_PERF_REG_STALLS_
+	};
+
+	/**
+	 * @brief Number of monitored events.
+	 */
+	#define BENCHMARK_PERF_EVENTS_NUM \
+		((int) (sizeof(benchmark_perf_events)/sizeof(benchmark_perf_events[0])))
+
+	/**
+	 * @brief Number of events other than cycles counted in a region.
+	 */
+	#define BENCHMARK_PERF_GROUP_SIZE (BENCHMARK_PERF_MONITORS - 1)
+
+	/**
+	 * @brief Measurement of a region.
+	 *
+	 * When there are more events than monitors, events are split in
+	 * groups and consecutive regions count different groups, so that
+	 * iterated benchmarks eventually cover all events.
+	 */
+	struct benchmark_perf
+	{
+		int group;                                  /**< Counted group.  */
+		uint64_t values[BENCHMARK_PERF_EVENTS_NUM]; /**< Counted values. */
+		int valid[BENCHMARK_PERF_EVENTS_NUM];       /**< Counted events. */
+	};
+
+	/**
+	 * @brief Next group of events to be counted.
+	 */
+	static int benchmark_perf_next_group = 0;
+
+	/**
+	 * @brief Cycles spent measuring an empty region.
+	 *
+	 * This is set by benchmark_calibrate() and subtracted from the cycles
+	 * of every measured region.
+	 */
+	static uint64_t benchmark_perf_overhead = 0;
+
+	/**
+	 * @brief Gets the number of groups of events.
+	 */
+	static inline int benchmark_perf_groups(void)
+	{
+		if ((BENCHMARK_PERF_GROUP_SIZE <= 0) || (BENCHMARK_PERF_EVENTS_NUM <= 1))
+			return (1);
+
+		return (
+			(BENCHMARK_PERF_EVENTS_NUM - 1 + BENCHMARK_PERF_GROUP_SIZE - 1) /
+			BENCHMARK_PERF_GROUP_SIZE
+		);
+	}
+
+	/**
+	 * @brief Gets the event counted by a monitor in a group.
+	 *
+	 * @param group   Target group.
+	 * @param monitor Target monitor.
+	 *
+	 * @returns The index of the event counted by @p monitor, or a negative
+	 * number if the monitor is unused.
+	 */
+	static inline int benchmark_perf_event(int group, int monitor)
+	{
+		int idx;
+
+		if (monitor == 0)
+			return (BENCHMARK_PERF_CYCLES);
+
+		idx = 1 + group*BENCHMARK_PERF_GROUP_SIZE + (monitor - 1);
+
+		return ((idx < BENCHMARK_PERF_EVENTS_NUM) ? idx : -1);
+	}
+
+	/**
+	 * @brief Starts measuring a region.
+	 *
+	 * @param p Store location for the measurement.
+	 *
+	 * @note Events that the target refuses to count are skipped.
+	 */
+	static inline void benchmark_perf_start(struct benchmark_perf *p)
+	{
+		int idx;
+
+		p->group = benchmark_perf_next_group;
+		benchmark_perf_next_group = (benchmark_perf_next_group + 1) % benchmark_perf_groups();
+
+		for (int i = 0; i < BENCHMARK_PERF_EVENTS_NUM; i++)
+			p->valid[i] = 0;
+
+		/* Cycles are started last, so that they account less overhead. */
+		for (int m = BENCHMARK_PERF_MONITORS - 1; m > 0; m--)
+		{
+			if ((idx = benchmark_perf_event(p->group, m)) >= 0)
+				p->valid[idx] = (perf_start(m, benchmark_perf_events[idx].event) == 0);
+		}
+
+		p->valid[BENCHMARK_PERF_CYCLES] = 1;
+		perf_start(0, PERF_CYCLES);
+	}
+
+	/**
+	 * @brief Stops measuring a region.
+	 *
+	 * @param p Target measurement.
+	 */
+	static inline void benchmark_perf_stop(struct benchmark_perf *p)
+	{
+		int idx;
+
+		/* Cycles are stopped first, so that they account less overhead. */
+		for (int m = 0; m < BENCHMARK_PERF_MONITORS; m++)
+		{
+			if (((idx = benchmark_perf_event(p->group, m)) >= 0) && p->valid[idx])
+				perf_stop(m);
+		}
+
+		for (int m = 0; m < BENCHMARK_PERF_MONITORS; m++)
+		{
+			if (((idx = benchmark_perf_event(p->group, m)) >= 0) && p->valid[idx])
+				p->values[idx] = perf_read(m);
+		}
+
+		/* Discount measurement overhead. */
+		p->values[BENCHMARK_PERF_CYCLES] =
+			(p->values[BENCHMARK_PERF_CYCLES] > benchmark_perf_overhead) ?
+			p->values[BENCHMARK_PERF_CYCLES] - benchmark_perf_overhead : 0;
+	}
+
+	/**
+	 * @brief Gets the cycles spent in a region.
+	 *
+	 * @param p Target measurement.
+	 */
+	static inline uint64_t benchmark_perf_cycles(const struct benchmark_perf *p)
+	{
+		return (p->values[BENCHMARK_PERF_CYCLES]);
+	}
+
+	/**
+	 * @brief Looks up a counted event by name.
+	 *
+	 * @param p    Target measurement.
+	 * @param name Name of the event.
+	 *
+	 * @returns The index of the event, or a negative number if it was not
+	 * counted in @p p.
+	 */
+	static inline int benchmark_perf_lookup(const struct benchmark_perf *p, const char *name)
+	{
+		for (int i = 0; i < BENCHMARK_PERF_EVENTS_NUM; i++)
+		{
+			if (p->valid[i] && (ustrcmp(benchmark_perf_events[i].name, name) == 0))
+				return (i);
+		}
+
+		return (-1);
+	}
+
+	/**
+	 * @brief Emits records for a measured region.
+	 *
+	 * @param benchmark Name of the benchmark.
+	 * @param variant   Variant of the benchmark.
+	 * @param iteration Iteration number.
+	 * @param region    Name of the region.
+	 * @param p         Target measurement.
+	 * @param bytes     Number of bytes transferred in the region (may be zero).
+	 *
+	 * Cycles and nanoseconds are reported under the @p region metric, other
+	 * events under "region.event", and bandwidth under "region.bandwidth".
+	 * Derived metrics are the number of instructions per cycle
+	 * ("region.ipc") and the number of misses per kilobyte transferred
+	 * ("region.event_per_kb"), both in thousandths.
+	 */
+	static inline void benchmark_perf_record(
+		const char *benchmark,
+		const char *variant,
+		int iteration,
+		const char *region,
+		const struct benchmark_perf *p,
+		size_t bytes
+	)
+	{
+		int idx;
+		uint64_t cycles;
+		char metric[BENCHMARK_VARIANT_MAX];
+
+		cycles = benchmark_perf_cycles(p);
+		benchmark_record_time(benchmark, variant, iteration, region, cycles);
+
+		if (bytes > 0)
+		{
+			usprintf(metric, "%s.bandwidth", region);
+			benchmark_record_bandwidth(benchmark, variant, iteration, metric, bytes, cycles);
+		}
+
+		for (int i = 1; i < BENCHMARK_PERF_EVENTS_NUM; i++)
+		{
+			if (!p->valid[i])
+				continue;
+
+			usprintf(metric, "%s.%s", region, benchmark_perf_events[i].name);
+			benchmark_record(benchmark, variant, iteration, metric, p->values[i], BENCHMARK_UNIT_COUNT);
+
+			if (benchmark_perf_events[i].per_byte && (bytes > 0))
+			{
+				usprintf(metric, "%s.%s_per_kb", region, benchmark_perf_events[i].name);
+				benchmark_record(benchmark, variant, iteration, metric,
+					(p->values[i]*1024*1000)/bytes,
+					BENCHMARK_UNIT_MILLI
+				);
+			}
+		}
+
+		if (((idx = benchmark_perf_lookup(p, "instructions")) >= 0) && (cycles > 0))
+		{
+			usprintf(metric, "%s.ipc", region);
+			benchmark_record(benchmark, variant, iteration, metric,
+				(p->values[idx]*1000)/cycles,
+				BENCHMARK_UNIT_MILLI
+			);
+		}
+	}
+
+#endif /* BENCHMARK_PERF_H_ */
@@ -0,0 +1,138 @@
+/*
+ * MIT License
+ *
+ * Copyright(c) 2011-2020 The Maintainers of Nanvix
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BENCHMARK_RECORD_H_
+#define BENCHMARK_RECORD_H_
+
+	#include <nanvix/runtime/runtime.h>
+	#include <nanvix/ulib.h>
+
+	/**
+	 * @brief Version of the record schema.
+	 *
+	 * Bump this whenever fields are added, removed or reordered, and
+	 * update scripts/collect.py accordingly.
+	 */
+	#define BENCHMARK_RECORD_VERSION 1
+
+	/**
+	 * @brief Tag that prefixes every record.
+	 */
+	#define BENCHMARK_RECORD_TAG "[benchmarks]"
+
+	/**
+	 * @brief Maximum length of a variant string.
+	 */
+	#define BENCHMARK_VARIANT_MAX 64
+
+	/**
+	 * @name Units
+	 */
+	/**@{*/
+	#define BENCHMARK_UNIT_CYCLES   "cycles"       /**< Clock cycles.        */
+	#define BENCHMARK_UNIT_BYTES    "bytes"        /**< Bytes.               */
+	#define BENCHMARK_UNIT_COUNT    "count"        /**< Events.              */
+	#define BENCHMARK_UNIT_OPS      "ops/s"        /**< Operations per sec.  */
+	#define BENCHMARK_UNIT_CYCLESKB "cycles/KB"    /**< Cycles per kilobyte. */
+	#define BENCHMARK_UNIT_CYCLESMB "cycles/MB"    /**< Cycles per megabyte. */
+	#define BENCHMARK_UNIT_CYCLESKN "cycles/Kname" /**< Cycles per kilo-name.*/
+	#define BENCHMARK_UNIT_PERMILLE "permille"     /**< Parts per thousand.  */
+	#define BENCHMARK_UNIT_MILLI    "milli"        /**< Thousandths of ratio.*/
+	#define BENCHMARK_UNIT_NS       "ns"           /**< Nanoseconds.         */
+	#define BENCHMARK_UNIT_BYTESPS  "bytes/s"      /**< Bytes per second.    */
+	#define BENCHMARK_UNIT_HZ       "Hz"           /**< Hertz.               */
+	#define BENCHMARK_UNIT_KEYS     "keys/s"       /**< Keys per second.     */
+	#define BENCHMARK_UNIT_FLOPS    "flop/s"       /**< Floating-point ops/s.*/
+	#define BENCHMARK_UNIT_RECORDS  "records/s"    /**< Records per second.  */
+	/**@}*/
+
+	/**
+	 * @brief Emits a benchmark record.
+	 *
+	 * @param benchmark Name of the benchmark (e.g. "cargo").
+	 * @param variant   Variant of the benchmark (e.g. "pingpong"). Parameters
+	 *                  of the variant are appended as ":key=value,key=value".
+	 * @param iteration Iteration number (zero for summaries).
+	 * @param metric    Name of the metric (e.g. "latency").
+	 * @param value     Value of the metric.
+	 * @param unit      Unit of the metric (see BENCHMARK_UNIT_*).
+	 *
+	 * Records are emitted as a single line with semicolon-separated fields:
+	 *
+	 *   [benchmarks];version;benchmark;variant;node;iteration;metric;value;unit
+	 */
+	static inline void benchmark_record(
+		const char *benchmark,
+		const char *variant,
+		int iteration,
+		const char *metric,
+		uint64_t value,
+		const char *unit
+	)
+	{
+		uprintf(BENCHMARK_RECORD_TAG ";%d;%s;%s;%d;%d;%s;%l;%s",
+			BENCHMARK_RECORD_VERSION,
+			benchmark,
+			variant,
+			knode_get_num(),
+			iteration,
+			metric,
+			value,
+			unit
+		);
+	}
+
+	/**
+	 * @brief Emits a benchmark record with a signed value.
+	 *
+	 * @see benchmark_record().
+	 */
+	static inline void benchmark_record_signed(
+		const char *benchmark,
+		const char *variant,
+		int iteration,
+		const char *metric,
+		int64_t value,
+		const char *unit
+	)
+	{
+		if (value >= 0)
+		{
+			benchmark_record(benchmark, variant, iteration, metric, (uint64_t) value, unit);
+			return;
+		}
+
+		uprintf(BENCHMARK_RECORD_TAG ";%d;%s;%s;%d;%d;%s;-%l;%s",
+			BENCHMARK_RECORD_VERSION,
+			benchmark,
+			variant,
+			knode_get_num(),
+			iteration,
+			metric,
+			(uint64_t) -value,
+			unit
+		);
+	}
+
+#endif /* BENCHMARK_RECORD_H_ */
@@ -0,0 +1,129 @@
+/*
+ * MIT License
+ *
+ * Copyright(c) 2011-2020 The Maintainers of Nanvix
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BENCHMARK_STATS_H_
+#define BENCHMARK_STATS_H_
+
+	#include <nanvix/ulib.h>
+
+	/**
+	 * @brief Sifts down a sample in a max-heap.
+	 *
+	 * @param samples Target samples.
+	 * @param root    Index of the sample to sift down.
+	 * @param end     Index of the last sample in the heap.
+	 */
+	static inline void stats_sift_down(uint64_t *samples, int root, int end)
+	{
+		uint64_t tmp;
+
+		while ((2*root + 1) <= end)
+		{
+			int child = 2*root + 1;
+			int swap = root;
+
+			if (samples[swap] < samples[child])
+				swap = child;
+			if (((child + 1) <= end) && (samples[swap] < samples[child + 1]))
+				swap = child + 1;
+			if (swap == root)
+				break;
+
+			tmp = samples[root];
+			samples[root] = samples[swap];
+			samples[swap] = tmp;
+			root = swap;
+		}
+	}
+
+	/**
+	 * @brief Sorts samples in ascending order.
+	 *
+	 * @param samples  Target samples.
+	 * @param nsamples Number of samples.
+	 *
+	 * @note This is a heapsort, so that large sample sets are sorted
+	 * in place and in O(n log n).
+	 */
+	static inline void stats_sort(uint64_t *samples, int nsamples)
+	{
+		uint64_t tmp;
+
+		for (int start = (nsamples - 2)/2; start >= 0; start--)
+			stats_sift_down(samples, start, nsamples - 1);
+
+		for (int end = nsamples - 1; end > 0; end--)
+		{
+			tmp = samples[0];
+			samples[0] = samples[end];
+			samples[end] = tmp;
+			stats_sift_down(samples, 0, end - 1);
+		}
+	}
+
+	/**
+	 * @brief Gets a percentile of sorted samples.
+	 *
+	 * @param samples  Target samples (sorted in ascending order).
+	 * @param nsamples Number of samples.
+	 * @param p        Target percentile (0 to 100).
+	 *
+	 * @returns The @p p percentile of @p samples, using the nearest-rank
+	 * method.
+	 */
+	static inline uint64_t stats_percentile(const uint64_t *samples, int nsamples, int p)
+	{
+		int rank;
+
+		if (nsamples <= 0)
+			return (0);
+
+		rank = (p*nsamples + 99)/100;
+		rank = (rank < 1) ? 1 : ((rank > nsamples) ? nsamples : rank);
+
+		return (samples[rank - 1]);
+	}
+
+	/**
+	 * @brief Computes the arithmetic mean of samples.
+	 *
+	 * @param samples  Target samples.
+	 * @param nsamples Number of samples.
+	 *
+	 * @returns The arithmetic mean of @p samples.
+	 */
+	static inline uint64_t stats_mean(const uint64_t *samples, int nsamples)
+	{
+		uint64_t sum = 0;
+
+		if (nsamples <= 0)
+			return (0);
+
+		for (int i = 0; i < nsamples; i++)
+			sum += samples[i];
+
+		return (sum/nsamples);
+	}
+
+#endif /* BENCHMARK_STATS_H_ */
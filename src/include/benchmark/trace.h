@@ -0,0 +1,234 @@
+/*
+ * MIT License
+ *
+ * Copyright(c) 2011-2020 The Maintainers of Nanvix
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BENCHMARK_TRACE_H_
+#define BENCHMARK_TRACE_H_
+
+	#include <nanvix/runtime/runtime.h>
+	#include <nanvix/ulib.h>
+
+	/**
+	 * @brief Is tracing enabled?
+	 *
+	 * Tracing is opt-in: build with ADDONS=-DBENCHMARK_TRACE to enable it.
+	 */
+	#ifdef BENCHMARK_TRACE
+	#define BENCHMARK_TRACE_ENABLED 1
+	#else
+	#define BENCHMARK_TRACE_ENABLED 0
+	#endif
+
+	/**
+	 * @brief Maximum number of events traced per node.
+	 */
+	#ifndef BENCHMARK_TRACE_SIZE
+	#define BENCHMARK_TRACE_SIZE 1024
+	#endif
+
+	/**
+	 * @brief Version of the trace schema.
+	 */
+	#define BENCHMARK_TRACE_VERSION 1
+
+	/**
+	 * @brief Tag that prefixes every traced event.
+	 */
+	#define BENCHMARK_TRACE_TAG "[trace]"
+
+	/**
+	 * @name Traced Events
+	 */
+	/**@{*/
+	#define BENCHMARK_TRACE_SEND     0 /**< Send a message.            */
+	#define BENCHMARK_TRACE_ALLOW    1 /**< Allow a transfer.          */
+	#define BENCHMARK_TRACE_READ     2 /**< Read a message.            */
+	#define BENCHMARK_TRACE_SIGNAL   3 /**< Signal a synchronization.  */
+	#define BENCHMARK_TRACE_WAIT     4 /**< Wait on a synchronization. */
+	#define BENCHMARK_TRACE_BARRIER  5 /**< Wait on a barrier.         */
+	#define BENCHMARK_TRACE_SYNC     6 /**< Clock synchronization.     */
+	#define BENCHMARK_TRACE_EXCHANGE 7 /**< Send and receive.          */
+	#define BENCHMARK_TRACE_EVENTS   8 /**< Number of traced events.   */
+	/**@}*/
+
+	/**
+	 * @name Event Phases
+	 */
+	/**@{*/
+	#define BENCHMARK_TRACE_BEGIN   0 /**< Event begins. */
+	#define BENCHMARK_TRACE_END     1 /**< Event ends.   */
+	#define BENCHMARK_TRACE_INSTANT 2 /**< Instant.      */
+	/**@}*/
+
+	/**
+	 * @brief Names of traced events.
+	 */
+	static const char *benchmark_trace_events[BENCHMARK_TRACE_EVENTS] = {
+		"send", "allow", "read", "signal", "wait", "barrier", "sync", "exchange"
+	};
+
+	/**
+	 * @brief Names of event phases (as in the Chrome trace format).
+	 */
+	static const char *benchmark_trace_phases[] = {
+		"B", "E", "i"
+	};
+
+	/**
+	 * @brief Traced event.
+	 */
+	struct benchmark_trace_event
+	{
+		uint64_t timestamp; /**< Clock reading.         */
+		short event;        /**< Event.                 */
+		short phase;        /**< Phase.                 */
+		int peer;           /**< Remote node (or -1).   */
+		size_t size;        /**< Bytes transferred.     */
+	};
+
+	/**
+	 * @brief Trace buffer.
+	 *
+	 * Each node traces its own events, so no locking is needed.
+	 */
+	static struct
+	{
+		int nevents; /**< Number of traced events.          */
+		int dropped; /**< Number of events that didn't fit. */
+		struct benchmark_trace_event events[BENCHMARK_TRACE_ENABLED ? BENCHMARK_TRACE_SIZE : 1];
+	} benchmark_trace_buffer;
+
+	/**
+	 * @brief Traces an event.
+	 *
+	 * @param event Event (see BENCHMARK_TRACE_*).
+	 * @param phase Phase (see BENCHMARK_TRACE_BEGIN and friends).
+	 * @param peer  Remote node, or -1 if none.
+	 * @param size  Bytes transferred, or zero if none.
+	 *
+	 * @note This only reads the clock and fills an entry of the trace
+	 * buffer, thus it is safe to call on the hot path.
+	 */
+	static inline void benchmark_trace(int event, int phase, int peer, size_t size)
+	{
+		struct benchmark_trace_event *e;
+
+		if (!BENCHMARK_TRACE_ENABLED)
+			return;
+
+		if (benchmark_trace_buffer.nevents == BENCHMARK_TRACE_SIZE)
+		{
+			benchmark_trace_buffer.dropped++;
+			return;
+		}
+
+		e = &benchmark_trace_buffer.events[benchmark_trace_buffer.nevents++];
+		kclock(&e->timestamp);
+		e->event = event;
+		e->phase = phase;
+		e->peer = peer;
+		e->size = size;
+	}
+
+	/**
+	 * @brief Traces the beginning of an event.
+	 *
+	 * @see benchmark_trace().
+	 */
+	static inline void benchmark_trace_begin(int event, int peer, size_t size)
+	{
+		benchmark_trace(event, BENCHMARK_TRACE_BEGIN, peer, size);
+	}
+
+	/**
+	 * @brief Traces the end of an event.
+	 *
+	 * @see benchmark_trace().
+	 */
+	static inline void benchmark_trace_end(int event, int peer, size_t size)
+	{
+		benchmark_trace(event, BENCHMARK_TRACE_END, peer, size);
+	}
+
+	/**
+	 * @brief Traces a clock synchronization point.
+	 *
+	 * Clocks of different nodes are not synchronized. This should be
+	 * called right after a rendezvous of all nodes (e.g. leaving a
+	 * barrier), and the collector then aligns the clocks of all nodes on
+	 * their first synchronization point.
+	 */
+	static inline void benchmark_trace_sync(void)
+	{
+		benchmark_trace(BENCHMARK_TRACE_SYNC, BENCHMARK_TRACE_INSTANT, -1, 0);
+	}
+
+	/**
+	 * @brief Dumps and clears the trace buffer.
+	 *
+	 * @param benchmark Name of the benchmark.
+	 * @param variant   Variant of the benchmark.
+	 *
+	 * Events are emitted as a single line with semicolon-separated fields:
+	 *
+	 *   [trace];version;benchmark;variant;node;timestamp;phase;event;peer;size
+	 *
+	 * This should be called only after the measured run.
+	 */
+	static inline void benchmark_trace_dump(const char *benchmark, const char *variant)
+	{
+		struct benchmark_trace_event *e;
+
+		if (!BENCHMARK_TRACE_ENABLED)
+			return;
+
+		for (int i = 0; i < benchmark_trace_buffer.nevents; i++)
+		{
+			e = &benchmark_trace_buffer.events[i];
+
+			uprintf(BENCHMARK_TRACE_TAG ";%d;%s;%s;%d;%l;%s;%s;%d;%d",
+				BENCHMARK_TRACE_VERSION,
+				benchmark,
+				variant,
+				knode_get_num(),
+				e->timestamp,
+				benchmark_trace_phases[e->phase],
+				benchmark_trace_events[e->event],
+				e->peer,
+				(int) e->size
+			);
+		}
+
+		if (benchmark_trace_buffer.dropped > 0)
+		{
+			uprintf("[benchmarks][trace] %d events dropped (BENCHMARK_TRACE_SIZE=%d)",
+				benchmark_trace_buffer.dropped,
+				BENCHMARK_TRACE_SIZE
+			);
+		}
+
+		benchmark_trace_buffer.nevents = 0;
+		benchmark_trace_buffer.dropped = 0;
+	}
+
+#endif /* BENCHMARK_TRACE_H_ */
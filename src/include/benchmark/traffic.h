@@ -0,0 +1,152 @@
+/*
+ * MIT License
+ *
+ * Copyright(c) 2011-2020 The Maintainers of Nanvix
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BENCHMARK_TRAFFIC_H_
+#define BENCHMARK_TRAFFIC_H_
+
+	#include <nanvix/runtime/runtime.h>
+	#include <nanvix/limits.h>
+	#include <nanvix/ulib.h>
+
+	/**
+	 * @brief Version of the traffic schema.
+	 */
+	#define BENCHMARK_TRAFFIC_VERSION 1
+
+	/**
+	 * @brief Tag that prefixes every traffic entry.
+	 */
+	#define BENCHMARK_TRAFFIC_TAG "[traffic]"
+
+	/**
+	 * @brief Number of peers accounted.
+	 *
+	 * Peers are indexed relative to the leader node. An extra slot
+	 * accounts for transfers whose peer is unknown (e.g. mailbox reads).
+	 */
+	#define BENCHMARK_TRAFFIC_PEERS (NANVIX_PROC_MAX + 1)
+
+	/**
+	 * @name Directions
+	 */
+	/**@{*/
+	#define BENCHMARK_TRAFFIC_SEND 0 /**< Outbound. */
+	#define BENCHMARK_TRAFFIC_RECV 1 /**< Inbound.  */
+	/**@}*/
+
+	/**
+	 * @brief Traffic between this node and a peer, in one direction.
+	 */
+	struct benchmark_traffic_link
+	{
+		uint64_t bytes;    /**< Bytes transferred.         */
+		uint64_t messages; /**< Messages transferred.      */
+		uint64_t blocked;  /**< Cycles spent blocked.      */
+	};
+
+	/**
+	 * @brief Traffic of this node, indexed by direction and peer.
+	 */
+	static struct benchmark_traffic_link benchmark_traffic[2][BENCHMARK_TRAFFIC_PEERS];
+
+	/**
+	 * @brief Returns the current time, to be passed to benchmark_traffic_account().
+	 */
+	static inline uint64_t benchmark_traffic_clock(void)
+	{
+		uint64_t now;
+
+		kclock(&now);
+
+		return (now);
+	}
+
+	/**
+	 * @brief Accounts a transfer.
+	 *
+	 * @param direction Direction (BENCHMARK_TRAFFIC_SEND or BENCHMARK_TRAFFIC_RECV).
+	 * @param peer      Remote node, or -1 if unknown.
+	 * @param bytes     Bytes transferred.
+	 * @param t0        Time at which the transfer was issued.
+	 */
+	static inline void benchmark_traffic_account(int direction, int peer, size_t bytes, uint64_t t0)
+	{
+		int idx;
+		uint64_t now;
+		struct benchmark_traffic_link *link;
+
+		kclock(&now);
+
+		idx = peer - PROCESSOR_NODENUM_LEADER;
+		if ((peer < 0) || (idx < 0) || (idx >= NANVIX_PROC_MAX))
+			idx = NANVIX_PROC_MAX;
+
+		link = &benchmark_traffic[direction][idx];
+		link->bytes += bytes;
+		link->messages++;
+		link->blocked += now - t0;
+	}
+
+	/**
+	 * @brief Dumps and clears traffic accounting.
+	 *
+	 * @param benchmark Name of the benchmark.
+	 * @param variant   Variant of the benchmark.
+	 *
+	 * One line is emitted for each peer that this node exchanged data
+	 * with, in each direction, with semicolon-separated fields:
+	 *
+	 *   [traffic];version;benchmark;variant;node;direction;peer;bytes;messages;blocked
+	 */
+	static inline void benchmark_traffic_dump(const char *benchmark, const char *variant)
+	{
+		struct benchmark_traffic_link *link;
+
+		for (int d = 0; d < 2; d++)
+		{
+			for (int i = 0; i < BENCHMARK_TRAFFIC_PEERS; i++)
+			{
+				link = &benchmark_traffic[d][i];
+
+				if (link->messages == 0)
+					continue;
+
+				uprintf(BENCHMARK_TRAFFIC_TAG ";%d;%s;%s;%d;%s;%d;%l;%l;%l",
+					BENCHMARK_TRAFFIC_VERSION,
+					benchmark,
+					variant,
+					knode_get_num(),
+					(d == BENCHMARK_TRAFFIC_SEND) ? "send" : "recv",
+					(i < NANVIX_PROC_MAX) ? PROCESSOR_NODENUM_LEADER + i : -1,
+					link->bytes,
+					link->messages,
+					link->blocked
+				);
+			}
+		}
+
+		umemset(benchmark_traffic, 0, sizeof(benchmark_traffic));
+	}
+
+#endif /* BENCHMARK_TRAFFIC_H_ */
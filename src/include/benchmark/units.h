@@ -0,0 +1,133 @@
+/*
+ * MIT License
+ *
+ * Copyright(c) 2011-2020 The Maintainers of Nanvix
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BENCHMARK_UNITS_H_
+#define BENCHMARK_UNITS_H_
+
+	#include <nanvix/runtime/runtime.h>
+	#include <nanvix/ulib.h>
+	#include <benchmark/record.h>
+
+	/**
+	 * @brief Frequency of the timer used for measurements (in Hz).
+	 *
+	 * Cycles read with kclock(), perf_read() and the ioctl() latencies
+	 * of the kernel are all counted at this frequency.
+	 */
+	#ifndef BENCHMARK_TIMER_FREQ
+	#define BENCHMARK_TIMER_FREQ CLUSTER_FREQ
+	#endif
+
+	/**
+	 * @brief Converts cycles to nanoseconds.
+	 *
+	 * @param cycles Number of cycles.
+	 *
+	 * @returns The number of nanoseconds elapsed in @p cycles.
+	 *
+	 * @note Whole seconds and the remainder are converted apart, so that
+	 * intermediate products do not overflow.
+	 */
+	static inline uint64_t benchmark_cycles_to_ns(uint64_t cycles)
+	{
+		uint64_t freq = BENCHMARK_TIMER_FREQ;
+
+		return (
+			(cycles/freq)*1000000000ULL +
+			((cycles%freq)*1000000000ULL)/freq
+		);
+	}
+
+	/**
+	 * @brief Computes bandwidth.
+	 *
+	 * @param bytes  Number of bytes transferred.
+	 * @param cycles Number of cycles spent in the transfer.
+	 *
+	 * @returns The bandwidth in bytes per second, or zero if @p cycles is zero.
+	 */
+	static inline uint64_t benchmark_bandwidth(uint64_t bytes, uint64_t cycles)
+	{
+		uint64_t freq = BENCHMARK_TIMER_FREQ;
+
+		if (cycles == 0)
+			return (0);
+
+		return (
+			(bytes/cycles)*freq +
+			((bytes%cycles)*freq)/cycles
+		);
+	}
+
+	/**
+	 * @brief Emits a time record, both in cycles and in nanoseconds.
+	 *
+	 * @see benchmark_record().
+	 */
+	static inline void benchmark_record_time(
+		const char *benchmark,
+		const char *variant,
+		int iteration,
+		const char *metric,
+		uint64_t cycles
+	)
+	{
+		benchmark_record(benchmark, variant, iteration, metric, cycles, BENCHMARK_UNIT_CYCLES);
+		benchmark_record(benchmark, variant, iteration, metric,
+			benchmark_cycles_to_ns(cycles),
+			BENCHMARK_UNIT_NS
+		);
+	}
+
+	/**
+	 * @brief Emits a bandwidth record.
+	 *
+	 * @param benchmark Name of the benchmark.
+	 * @param variant   Variant of the benchmark.
+	 * @param iteration Iteration number.
+	 * @param metric    Name of the metric.
+	 * @param bytes     Number of bytes transferred.
+	 * @param cycles    Number of cycles spent in the transfer.
+	 *
+	 * Nothing is emitted if no time was spent in the transfer.
+	 */
+	static inline void benchmark_record_bandwidth(
+		const char *benchmark,
+		const char *variant,
+		int iteration,
+		const char *metric,
+		uint64_t bytes,
+		uint64_t cycles
+	)
+	{
+		if (cycles == 0)
+			return;
+
+		benchmark_record(benchmark, variant, iteration, metric,
+			benchmark_bandwidth(bytes, cycles),
+			BENCHMARK_UNIT_BYTESPS
+		);
+	}
+
+#endif /* BENCHMARK_UNITS_H_ */
@@ -0,0 +1,300 @@
+/*
+ * MIT License
+ *
+ * Copyright(c) 2011-2020 The Maintainers of Nanvix
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <nanvix/runtime/runtime.h>
+#include <nanvix/runtime/barrier.h>
+#include <nanvix/sys/perf.h>
+#include <nanvix/limits.h>
+#include <nanvix/ulib.h>
+#include <benchmark/record.h>
+#include <benchmark/units.h>
+#include <benchmark/calibration.h>
+
+/**
+ * @brief Number of iterations for the benchmark.
+ */
+#ifdef NDEBUG
+#define NITERATIONS 30
+#else
+#define NITERATIONS 1
+#endif
+
+static barrier_t barrier;
+static int nodes[NANVIX_PROC_MAX];
+
+/*============================================================================*
+ * Benchmark Kernel                                                           *
+ *============================================================================*/
+
+/**
+ * @brief Smallest block size (in bytes).
+ */
+#ifndef BLOCK_SIZE_MIN
+#define BLOCK_SIZE_MIN 512
+#endif
+
+/**
+ * @brief Largest block size (in bytes).
+ */
+#ifndef BLOCK_SIZE_MAX
+#define BLOCK_SIZE_MAX 4096
+#endif
+
+/**
+ * @brief Port number used in the benchmark.
+ */
+#define PORT_NUM 0
+
+/**
+ * @name Algorithms
+ */
+/**@{*/
+#define ALGORITHM_FLAT      0 /**< Flat.               */
+#define ALGORITHM_RING      1 /**< Ring.               */
+#define ALGORITHM_RECURSIVE 2 /**< Recursive doubling. */
+#define ALGORITHMS_NUM      3 /**< Number of algorithms. */
+/**@}*/
+
+/**
+ * @brief Names of algorithms.
+ */
+static const char *algorithms[ALGORITHMS_NUM] = { "flat", "ring", "recursive" };
+
+/**
+ * @brief Portals.
+ */
+/**@{*/
+static int inportal;
+static int outportals[NANVIX_PROC_MAX];
+/**@}*/
+
+/**
+ * @brief Buffer holding the blocks of all nodes.
+ */
+static char buffer[NANVIX_PROC_MAX*BLOCK_SIZE_MAX];
+
+/**
+ * @brief Exchanges data with nodes.
+ *
+ * The write is issued asynchronously, so that both sides of an exchange
+ * may send at the same time.
+ */
+static void do_sendrecv(int to, const char *sendbuf, int from, char *recvbuf, size_t size)
+{
+	uassert(kportal_awrite(outportals[to], sendbuf, size) == (ssize_t) size);
+	uassert(kportal_allow(inportal, PROCESSOR_NODENUM_LEADER + from, PORT_NUM) == 0);
+	uassert(kportal_read(inportal, recvbuf, size) == (ssize_t) size);
+	uassert(kportal_wait(outportals[to]) == 0);
+}
+
+/**
+ * @brief Flat allgather: at step s, each node sends its block to the node
+ * s positions ahead, and receives from the node s positions behind.
+ */
+static void allgather_flat(int me, int nnodes, size_t block)
+{
+	int to, from;
+
+	for (int s = 1; s < nnodes; s++)
+	{
+		to = (me + s) % nnodes;
+		from = (me - s + nnodes) % nnodes;
+
+		do_sendrecv(to, &buffer[me*block], from, &buffer[from*block], block);
+	}
+}
+
+/**
+ * @brief Ring allgather: at each step, each node forwards to its right
+ * neighbor the block it received last.
+ */
+static void allgather_ring(int me, int nnodes, size_t block)
+{
+	int left, right;
+	int sendblk, recvblk;
+
+	left = (me - 1 + nnodes) % nnodes;
+	right = (me + 1) % nnodes;
+
+	for (int s = 0; s < (nnodes - 1); s++)
+	{
+		sendblk = (me - s + nnodes) % nnodes;
+		recvblk = (me - s - 1 + nnodes) % nnodes;
+
+		do_sendrecv(right, &buffer[sendblk*block], left, &buffer[recvblk*block], block);
+	}
+}
+
+/**
+ * @brief Recursive-doubling allgather: at each step, each node exchanges
+ * all blocks it has with a node that is twice as far away.
+ */
+static void allgather_recursive(int me, int nnodes, size_t block)
+{
+	int partner;
+
+	for (int mask = 1; mask < nnodes; mask <<= 1)
+	{
+		partner = me ^ mask;
+
+		do_sendrecv(
+			partner, &buffer[(me & ~(mask - 1))*block],
+			partner, &buffer[(partner & ~(mask - 1))*block],
+			mask*block
+		);
+	}
+}
+
+/**
+ * @brief Allgather algorithms.
+ */
+static void (*allgather_fns[ALGORITHMS_NUM])(int, int, size_t) = {
+	allgather_flat,
+	allgather_ring,
+	allgather_recursive
+};
+
+/**
+ * @brief Runs an allgather.
+ *
+ * @param algorithm Algorithm.
+ * @param nnodes    Number of nodes.
+ * @param block     Block size (in bytes).
+ */
+static void benchmark_allgather(int algorithm, int nnodes, size_t block)
+{
+	int me;
+	uint64_t t0, t1;
+	uint64_t local0, local1;
+	char variant[BENCHMARK_VARIANT_MAX];
+
+	me = knode_get_num() - PROCESSOR_NODENUM_LEADER;
+
+	usprintf(variant, "allgather:algo=%s,block=%d,nodes=%d",
+		algorithms[algorithm],
+		(int) block,
+		nnodes
+	);
+
+	for (int i = 1; i <= NITERATIONS; i++)
+	{
+		/* Each node owns one block, filled with its index. */
+		umemset(buffer, 0xff, nnodes*block);
+		umemset(&buffer[me*block], me, block);
+
+		uassert(barrier_wait(barrier) == 0);
+		kclock(&t0);
+
+			kclock(&local0);
+			if (me < nnodes)
+				allgather_fns[algorithm](me, nnodes, block);
+			kclock(&local1);
+
+		uassert(barrier_wait(barrier) == 0);
+		kclock(&t1);
+
+		if (me >= nnodes)
+			continue;
+
+		for (int j = 0; j < nnodes; j++)
+		{
+			uassert(buffer[j*block] == j);
+			uassert(buffer[(j + 1)*block - 1] == j);
+		}
+
+		/* Dump statistics. */
+		benchmark_record_time("cargo", variant, i, "local", benchmark_elapsed(local0, local1));
+		if (me == 0)
+		{
+			benchmark_record_time("cargo", variant, i, "completion", benchmark_elapsed(t0, t1));
+			benchmark_record_bandwidth("cargo", variant, i, "bandwidth",
+				nnodes*(nnodes - 1)*block,
+				benchmark_elapsed(t0, t1)
+			);
+		}
+	}
+}
+
+/**
+ * @brief Benchmarks allgather communication with portals.
+ */
+static void benchmark_cargo_allgather(void)
+{
+	int me;
+
+	me = knode_get_num() - PROCESSOR_NODENUM_LEADER;
+
+	/* Build list of nodes. */
+	for (int i = 0; i < NANVIX_PROC_MAX; i++)
+		nodes[i] = PROCESSOR_NODENUM_LEADER + i;
+
+	barrier = barrier_create(nodes, NANVIX_PROC_MAX);
+	uassert(BARRIER_IS_VALID(barrier));
+
+	/* Establish connections. */
+	uassert((inportal = kportal_create(knode_get_num(), PORT_NUM)) >= 0);
+	for (int i = 0; i < NANVIX_PROC_MAX; i++)
+	{
+		if (i != me)
+			uassert((outportals[i] = kportal_open(knode_get_num(), nodes[i], PORT_NUM)) >= 0);
+	}
+
+		for (int nnodes = 2; nnodes <= NANVIX_PROC_MAX; nnodes *= 2)
+		{
+			for (size_t block = BLOCK_SIZE_MIN; block <= BLOCK_SIZE_MAX; block *= 2)
+			{
+				for (int algorithm = 0; algorithm < ALGORITHMS_NUM; algorithm++)
+					benchmark_allgather(algorithm, nnodes, block);
+			}
+		}
+
+	/* House keeping. */
+	for (int i = 0; i < NANVIX_PROC_MAX; i++)
+	{
+		if (i != me)
+			uassert(kportal_close(outportals[i]) == 0);
+	}
+	uassert(kportal_unlink(inportal) == 0);
+
+	uassert(barrier_destroy(barrier) == 0);
+}
+
+/*============================================================================*
+ * Benchmark Driver                                                           *
+ *============================================================================*/
+
+/**
+ * @brief Launches a benchmark.
+ */
+int __main3(int argc, const char *argv[])
+{
+	((void) argc);
+	((void) argv);
+
+	benchmark_calibrate();
+
+	benchmark_cargo_allgather();
+
+	return (0);
+}
@@ -0,0 +1,306 @@
+/*
+ * MIT License
+ *
+ * Copyright(c) 2011-2020 The Maintainers of Nanvix
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <nanvix/runtime/runtime.h>
+#include <nanvix/runtime/barrier.h>
+#include <nanvix/sys/perf.h>
+#include <nanvix/limits.h>
+#include <nanvix/ulib.h>
+#include <benchmark/record.h>
+#include <benchmark/units.h>
+#include <benchmark/calibration.h>
+
+/**
+ * @brief Number of iterations for the benchmark.
+ */
+#ifdef NDEBUG
+#define NITERATIONS 30
+#else
+#define NITERATIONS 1
+#endif
+
+static barrier_t barrier;
+static int nodes[NANVIX_PROC_MAX];
+
+/*============================================================================*
+ * Benchmark Kernel                                                           *
+ *============================================================================*/
+
+/**
+ * @brief Size of buffers (in bytes)
+ */
+#ifndef BUFFER_SIZE
+#define BUFFER_SIZE 4096
+#endif
+
+/**
+ * @brief Port number used in the benchmark.
+ */
+#define PORT_NUM 0
+
+/**
+ * @name Placement of communicating nodes.
+ */
+/**@{*/
+#define MODE_PAIR     0 /**< Nodes 0 and 1 only.             */
+#define MODE_DISJOINT 1 /**< All nodes, node i with i + P/2. */
+/**@}*/
+
+/**
+ * @brief Names of placements.
+ */
+static const char *modes[] = { "pair", "disjoint" };
+
+/**
+ * @brief Buffers.
+ */
+/**@{*/
+static char sendbuf[BUFFER_SIZE];
+static char recvbuf[BUFFER_SIZE];
+/**@}*/
+
+/**
+ * @brief Input portal.
+ */
+static int inportal;
+
+/**
+ * @brief Reads the latency and volume of a portal.
+ */
+static void portal_counters(int portalid, uint64_t *latency, uint64_t *volume)
+{
+	uassert(kportal_ioctl(portalid, KPORTAL_IOCTL_GET_LATENCY, latency) == 0);
+	uassert(kportal_ioctl(portalid, KPORTAL_IOCTL_GET_VOLUME, volume) == 0);
+}
+
+/**
+ * @brief Returns the partner of a node, or -1 if the node is idle.
+ *
+ * @param me   Index of the node.
+ * @param mode Placement of communicating nodes.
+ */
+static int partner_of(int me, int mode)
+{
+	int half;
+
+	if (mode == MODE_PAIR)
+		return ((me < 2) ? (me ^ 1) : -1);
+
+	half = NANVIX_PROC_MAX/2;
+
+	if (me < half)
+		return (me + half);
+
+	return ((me < 2*half) ? (me - half) : -1);
+}
+
+/**
+ * @brief Exchanges data with a partner.
+ *
+ * @param me      Index of the node.
+ * @param partner Index of the partner.
+ * @param bidir   Send in both directions?
+ * @param variant Variant of the benchmark.
+ *
+ * @returns The total time of the transfers of all nodes (in cycles).
+ */
+static uint64_t do_exchange(int me, int partner, int bidir, const char *variant)
+{
+	int outportal;
+	int sending, receiving;
+	uint64_t t0, t1, t2;
+	uint64_t window = 0;
+	uint64_t out_latency0, out_volume0, out_latency1, out_volume1;
+	uint64_t in_latency0, in_volume0, in_latency1, in_volume1;
+
+	/* Lower node of each pair always sends. */
+	sending = bidir || (me < partner);
+	receiving = bidir || (me > partner);
+
+	uassert((
+		outportal = kportal_open(
+			knode_get_num(),
+			PROCESSOR_NODENUM_LEADER + partner,
+			PORT_NUM
+		)) >= 0
+	);
+
+	portal_counters(outportal, &out_latency0, &out_volume0);
+	portal_counters(inportal, &in_latency0, &in_volume0);
+
+	for (int i = 1; i <= NITERATIONS; i++)
+	{
+		uassert(barrier_wait(barrier) == 0);
+
+		kclock(&t0);
+
+			if (sending)
+				uassert(kportal_awrite(outportal, sendbuf, BUFFER_SIZE) == BUFFER_SIZE);
+
+			if (receiving)
+			{
+				uassert(kportal_allow(inportal, PROCESSOR_NODENUM_LEADER + partner, PORT_NUM) == 0);
+				uassert(kportal_read(inportal, recvbuf, BUFFER_SIZE) == BUFFER_SIZE);
+			}
+
+			if (sending)
+				uassert(kportal_wait(outportal) == 0);
+
+		kclock(&t1);
+
+		/* All transfers of this iteration are done. */
+		uassert(barrier_wait(barrier) == 0);
+		kclock(&t2);
+		window += benchmark_elapsed(t0, t2);
+
+		portal_counters(outportal, &out_latency1, &out_volume1);
+		portal_counters(inportal, &in_latency1, &in_volume1);
+
+		/* Dump statistics. */
+		benchmark_record_time("cargo", variant, i, "exchange", benchmark_elapsed(t0, t1));
+		if (sending)
+		{
+			benchmark_record_bandwidth("cargo", variant, i, "send",
+				out_volume1 - out_volume0,
+				out_latency1 - out_latency0
+			);
+		}
+		if (receiving)
+		{
+			benchmark_record_bandwidth("cargo", variant, i, "recv",
+				in_volume1 - in_volume0,
+				in_latency1 - in_latency0
+			);
+		}
+		benchmark_record_bandwidth("cargo", variant, i, "node",
+			(sending + receiving)*BUFFER_SIZE,
+			benchmark_elapsed(t0, t1)
+		);
+
+		out_latency0 = out_latency1;
+		out_volume0  = out_volume1;
+		in_latency0  = in_latency1;
+		in_volume0   = in_volume1;
+	}
+
+	uassert(kportal_close(outportal) == 0);
+
+	return (window);
+}
+
+/**
+ * @brief Runs exchanges with a given placement.
+ *
+ * @param mode  Placement of communicating nodes.
+ * @param bidir Send in both directions?
+ */
+static void benchmark_exchanges(int mode, int bidir)
+{
+	int me;
+	int partner;
+	int npairs;
+	uint64_t window;
+	char variant[BENCHMARK_VARIANT_MAX];
+
+	me = knode_get_num() - PROCESSOR_NODENUM_LEADER;
+	partner = partner_of(me, mode);
+	npairs = (mode == MODE_PAIR) ? 1 : NANVIX_PROC_MAX/2;
+
+	usprintf(variant, "bidir:mode=%s,dir=%s,pairs=%d",
+		modes[mode],
+		bidir ? "bi" : "uni",
+		npairs
+	);
+
+	uassert(barrier_wait(barrier) == 0);
+
+		if (partner >= 0)
+			window = do_exchange(me, partner, bidir, variant);
+		else
+		{
+			/* Idle nodes join the barriers around each transfer. */
+			for (int i = 1; i <= NITERATIONS; i++)
+			{
+				uassert(barrier_wait(barrier) == 0);
+				uassert(barrier_wait(barrier) == 0);
+			}
+			window = 0;
+		}
+
+	/*
+	 * Aggregate bandwidth across all pairs, over the barrier-bounded
+	 * transfers only, so that opening and closing portals is left out.
+	 */
+	if (me == 0)
+	{
+		benchmark_record_bandwidth("cargo", variant, 0, "aggregate",
+			((uint64_t) npairs)*(bidir ? 2 : 1)*NITERATIONS*BUFFER_SIZE,
+			window
+		);
+	}
+}
+
+/**
+ * @brief Benchmarks simultaneous exchanges with portals.
+ */
+static void benchmark_cargo_bidir(void)
+{
+	/* Build list of nodes. */
+	for (int i = 0; i < NANVIX_PROC_MAX; i++)
+		nodes[i] = PROCESSOR_NODENUM_LEADER + i;
+
+	barrier = barrier_create(nodes, NANVIX_PROC_MAX);
+	uassert(BARRIER_IS_VALID(barrier));
+
+	uassert((inportal = kportal_create(knode_get_num(), PORT_NUM)) >= 0);
+
+		for (int mode = MODE_PAIR; mode <= MODE_DISJOINT; mode++)
+		{
+			benchmark_exchanges(mode, 0);
+			benchmark_exchanges(mode, 1);
+		}
+
+	uassert(kportal_unlink(inportal) == 0);
+
+	uassert(barrier_destroy(barrier) == 0);
+}
+
+/*============================================================================*
+ * Benchmark Driver                                                           *
+ *============================================================================*/
+
+/**
+ * @brief Launches a benchmark.
+ */
+int __main3(int argc, const char *argv[])
+{
+	((void) argc);
+	((void) argv);
+
+	benchmark_calibrate();
+
+	benchmark_cargo_bidir();
+
+	return (0);
+}
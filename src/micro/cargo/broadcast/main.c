@@ -26,6 +26,11 @@
 #include <nanvix/sys/perf.h>
 #include <nanvix/limits.h>
 #include <nanvix/ulib.h>
+#include <benchmark/record.h>
+#include <benchmark/units.h>
+#include <benchmark/calibration.h>
+#include <benchmark/trace.h>
+#include <benchmark/traffic.h>
 
 /**
  * @brief Number of iterations for the benchmark.
@@ -60,6 +65,7 @@ static char buf[BUFFER_SIZE];
  */
 static void do_leader(void)
 {
+	uint64_t t0;
 	int outportals[NANVIX_PROC_MAX - 1];
 
 	/* Establish connection. */
@@ -79,6 +85,8 @@ static void do_leader(void)
 	{
 		for (int i = 1; i < NANVIX_PROC_MAX; i++)
 		{
+			benchmark_trace_begin(BENCHMARK_TRACE_SEND, PROCESSOR_NODENUM_LEADER + i, BUFFER_SIZE);
+			t0 = benchmark_traffic_clock();
 			uassert(
 				kportal_write(
 					outportals[i - 1],
@@ -86,9 +94,14 @@ static void do_leader(void)
 					BUFFER_SIZE
 				) == BUFFER_SIZE
 			);
+			benchmark_traffic_account(BENCHMARK_TRAFFIC_SEND, PROCESSOR_NODENUM_LEADER + i, BUFFER_SIZE, t0);
+			benchmark_trace_end(BENCHMARK_TRACE_SEND, PROCESSOR_NODENUM_LEADER + i, BUFFER_SIZE);
 		}
 	}
 
+	benchmark_trace_dump("cargo", "broadcast");
+	benchmark_traffic_dump("cargo", "broadcast");
+
 	/* House keeping. */
 	for (int i = 1; i < NANVIX_PROC_MAX; i++)
 		uassert(kportal_close(outportals[i - 1]) == 0);
@@ -100,6 +113,7 @@ static void do_leader(void)
 static void do_worker(void)
 {
 	int inportal;
+	uint64_t t0;
 	uint64_t latency, volume;
 
 	/* Establish connection. */
@@ -108,21 +122,25 @@ static void do_worker(void)
 	for (int i = 1; i <= NITERATIONS; i++)
 	{
 		uassert(kportal_allow(inportal, PROCESSOR_NODENUM_LEADER, PORT_NUM) == 0);
+		benchmark_trace(BENCHMARK_TRACE_ALLOW, BENCHMARK_TRACE_INSTANT, PROCESSOR_NODENUM_LEADER, BUFFER_SIZE);
+		benchmark_trace_begin(BENCHMARK_TRACE_READ, PROCESSOR_NODENUM_LEADER, BUFFER_SIZE);
+		t0 = benchmark_traffic_clock();
 		uassert(kportal_read(inportal, buf,  BUFFER_SIZE) == BUFFER_SIZE);
+		benchmark_traffic_account(BENCHMARK_TRAFFIC_RECV, PROCESSOR_NODENUM_LEADER, BUFFER_SIZE, t0);
+		benchmark_trace_end(BENCHMARK_TRACE_READ, PROCESSOR_NODENUM_LEADER, BUFFER_SIZE);
 		
 		uassert(kportal_ioctl(inportal, KPORTAL_IOCTL_GET_LATENCY, &latency) == 0);
 		uassert(kportal_ioctl(inportal, KPORTAL_IOCTL_GET_VOLUME, &volume) == 0);
 
 		/* Dump statistics. */
-#ifndef NDEBUG
-		uprintf("[benchmarks][cargo][broadcast] it=%d latency=%l volume=%l",
-#else
-		uprintf("cargo;broadcast;%d;%l;%l",
-#endif
-			i, latency, volume
-		);
+		benchmark_record_time("cargo", "broadcast", i, "latency", latency);
+		benchmark_record("cargo", "broadcast", i, "volume", volume, BENCHMARK_UNIT_BYTES);
+		benchmark_record_bandwidth("cargo", "broadcast", i, "bandwidth", volume, latency);
 	}
 
+	benchmark_trace_dump("cargo", "broadcast");
+	benchmark_traffic_dump("cargo", "broadcast");
+
 	/* House keeping. */
 	uassert(kportal_unlink(inportal) == 0);
 }
@@ -152,6 +170,8 @@ int __main3(int argc, const char *argv[])
 	((void) argc);
 	((void) argv);
 
+	benchmark_calibrate();
+
 	benchmark_cargo_broadcast();
 
 	return (0);
@@ -26,6 +26,11 @@
 #include <nanvix/sys/perf.h>
 #include <nanvix/limits.h>
 #include <nanvix/ulib.h>
+#include <benchmark/record.h>
+#include <benchmark/units.h>
+#include <benchmark/calibration.h>
+#include <benchmark/trace.h>
+#include <benchmark/traffic.h>
 
 /**
  * @brief Number of iterations for the benchmark.
@@ -61,6 +66,7 @@ static char buf[BUFFER_SIZE];
 static void do_leader(void)
 {
 	int inportal;
+	uint64_t t0;
 	uint64_t latency, volume;
 
 	/* Establish connection. */
@@ -78,6 +84,9 @@ static void do_leader(void)
 					PORT_NUM
 				) == 0
 			);
+			benchmark_trace(BENCHMARK_TRACE_ALLOW, BENCHMARK_TRACE_INSTANT, PROCESSOR_NODENUM_LEADER + i, BUFFER_SIZE);
+			benchmark_trace_begin(BENCHMARK_TRACE_READ, PROCESSOR_NODENUM_LEADER + i, BUFFER_SIZE);
+			t0 = benchmark_traffic_clock();
 			uassert(
 				kportal_read(
 					inportal,
@@ -85,21 +94,22 @@ static void do_leader(void)
 					BUFFER_SIZE
 				) == BUFFER_SIZE
 			);
+			benchmark_traffic_account(BENCHMARK_TRAFFIC_RECV, PROCESSOR_NODENUM_LEADER + i, BUFFER_SIZE, t0);
+			benchmark_trace_end(BENCHMARK_TRACE_READ, PROCESSOR_NODENUM_LEADER + i, BUFFER_SIZE);
 		}
 		
 		uassert(kportal_ioctl(inportal, KPORTAL_IOCTL_GET_LATENCY, &latency) == 0);
 		uassert(kportal_ioctl(inportal, KPORTAL_IOCTL_GET_VOLUME, &volume) == 0);
 
 		/* Dump statistics. */
-#ifndef NDEBUG
-		uprintf("[benchmarks][cargo][gather] it=%d latency=%l volume=%l",
-#else
-		uprintf("cargo;gather;%d;%l;%l",
-#endif
-			k, latency, volume
-		);
+		benchmark_record_time("cargo", "gather", k, "latency", latency);
+		benchmark_record("cargo", "gather", k, "volume", volume, BENCHMARK_UNIT_BYTES);
+		benchmark_record_bandwidth("cargo", "gather", k, "bandwidth", volume, latency);
 	}
 
+	benchmark_trace_dump("cargo", "gather");
+	benchmark_traffic_dump("cargo", "gather");
+
 	/* House keeping. */
 	uassert(kportal_unlink(inportal) == 0);
 }
@@ -110,12 +120,22 @@ static void do_leader(void)
 static void do_worker(void)
 {
 	int outportal;
+	uint64_t t0;
 
 	/* Establish connection. */
 	uassert((outportal = kportal_open(knode_get_num(), PROCESSOR_NODENUM_LEADER, PORT_NUM)) >= 0);
 
 	for (int i = 1; i <= NITERATIONS; i++)
+	{
+		benchmark_trace_begin(BENCHMARK_TRACE_SEND, PROCESSOR_NODENUM_LEADER, BUFFER_SIZE);
+		t0 = benchmark_traffic_clock();
 		uassert(kportal_write(outportal, buf, BUFFER_SIZE) == BUFFER_SIZE);
+		benchmark_traffic_account(BENCHMARK_TRAFFIC_SEND, PROCESSOR_NODENUM_LEADER, BUFFER_SIZE, t0);
+		benchmark_trace_end(BENCHMARK_TRACE_SEND, PROCESSOR_NODENUM_LEADER, BUFFER_SIZE);
+	}
+
+	benchmark_trace_dump("cargo", "gather");
+	benchmark_traffic_dump("cargo", "gather");
 
 	/* House keeping. */
 	uassert(kportal_close(outportal) == 0);
@@ -146,6 +166,8 @@ int __main3(int argc, const char *argv[])
 	((void) argc);
 	((void) argv);
 
+	benchmark_calibrate();
+
 	benchmark_cargo_gather();
 
 	return (0);
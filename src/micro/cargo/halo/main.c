@@ -0,0 +1,603 @@
+/*
+ * MIT License
+ *
+ * Copyright(c) 2011-2020 The Maintainers of Nanvix
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <nanvix/runtime/runtime.h>
+#include <nanvix/runtime/barrier.h>
+#include <nanvix/sys/perf.h>
+#include <nanvix/limits.h>
+#include <nanvix/ulib.h>
+#include <benchmark/record.h>
+#include <benchmark/units.h>
+#include <benchmark/calibration.h>
+
+/**
+ * @brief Number of iterations for the benchmark.
+ */
+#ifdef NDEBUG
+#define NITERATIONS 30
+#else
+#define NITERATIONS 1
+#endif
+
+static barrier_t barrier;
+static int nodes[NANVIX_PROC_MAX];
+
+/*============================================================================*
+ * Benchmark Kernel                                                           *
+ *============================================================================*/
+
+/**
+ * @brief Edge of the local tile in 2D grids (in cells).
+ */
+#ifndef TILE_2D
+#define TILE_2D 64
+#endif
+
+/**
+ * @brief Edge of the local tile in 3D grids (in cells).
+ */
+#ifndef TILE_3D
+#define TILE_3D 16
+#endif
+
+/**
+ * @brief Number of Jacobi sweeps per iteration.
+ *
+ * Raise this to make the compute kernel heavier relative to the halo
+ * exchange.
+ */
+#ifndef JACOBI_SWEEPS
+#define JACOBI_SWEEPS 1
+#endif
+
+/**
+ * @brief Port number of the first halo direction.
+ */
+#define PORT_BASE 0
+
+/**
+ * @brief Maximum number of dimensions.
+ */
+#define NDIMS_MAX 3
+
+/**
+ * @brief Number of halo directions.
+ */
+#define NDIRS (2*NDIMS_MAX)
+
+/**
+ * @brief Largest face of a tile (in cells).
+ */
+#define FACE_MAX ((TILE_2D > TILE_3D*TILE_3D) ? TILE_2D : TILE_3D*TILE_3D)
+
+/**
+ * @brief Largest tile, including halos (in cells).
+ */
+#define GRID_MAX \
+	(((TILE_2D + 2)*(TILE_2D + 2) > (TILE_3D + 2)*(TILE_3D + 2)*(TILE_3D + 2)) ? \
+	(TILE_2D + 2)*(TILE_2D + 2) : (TILE_3D + 2)*(TILE_3D + 2)*(TILE_3D + 2))
+
+/**
+ * @name Modes
+ */
+/**@{*/
+#define MODE_BLOCKING 0 /**< Exchange halos, then compute. */
+#define MODE_OVERLAP  1 /**< Compute interior while exchanging halos. */
+/**@}*/
+
+/**
+ * @name Regions of a tile.
+ */
+/**@{*/
+#define REGION_ALL      0 /**< All cells.                          */
+#define REGION_INTERIOR 1 /**< Cells that do not depend on halos.  */
+#define REGION_BOUNDARY 2 /**< Cells that depend on halos.         */
+/**@}*/
+
+/**
+ * @brief Logical grid of nodes and local tile.
+ */
+static struct
+{
+	int ndims;              /**< Number of dimensions.              */
+	int dims[NDIMS_MAX];    /**< Nodes along each axis.             */
+	int coords[NDIMS_MAX];  /**< Coordinates of this node.          */
+	int tile[NDIMS_MAX];    /**< Cells along each axis.             */
+	int extent[NDIMS_MAX];  /**< Cells along each axis, with halos. */
+	int offset[NDIMS_MAX];  /**< Offset of the first non-halo cell. */
+	int neighbors[NDIRS];   /**< Neighbor in each direction.        */
+	int facesize[NDIMS_MAX];/**< Cells in a face normal to an axis. */
+} grid;
+
+/**
+ * @brief Tiles (current and next).
+ */
+static float tiles[2][GRID_MAX];
+
+/**
+ * @brief Face buffers.
+ */
+/**@{*/
+static float sendbufs[NDIRS][FACE_MAX];
+static float recvbufs[NDIRS][FACE_MAX];
+/**@}*/
+
+/**
+ * @brief Portals, one per halo direction.
+ */
+/**@{*/
+static int inportals[NDIRS];
+static int outportals[NDIRS];
+/**@}*/
+
+/**
+ * @brief Direction along an axis.
+ *
+ * @param axis Axis.
+ * @param up   Towards higher coordinates?
+ */
+#define DIRECTION(axis, up) (2*(axis) + ((up) ? 1 : 0))
+
+/**
+ * @brief Opposite direction.
+ */
+#define OPPOSITE(dir) ((dir) ^ 1)
+
+/**
+ * @brief Index of a cell in a tile.
+ */
+static inline int cell(int x, int y, int z)
+{
+	return (
+		(x + grid.offset[0]) + grid.extent[0]*(
+		(y + grid.offset[1]) + grid.extent[1]*
+		(z + grid.offset[2]))
+	);
+}
+
+/**
+ * @brief Factors nodes into a logical grid.
+ *
+ * Prime factors are assigned, largest first, to the shortest axis, so
+ * that the grid is as close to a square (or cube) as possible.
+ */
+static void grid_factor(int nnodes, int ndims)
+{
+	int n;
+	int axis;
+
+	for (int a = 0; a < NDIMS_MAX; a++)
+		grid.dims[a] = 1;
+
+	n = nnodes;
+	for (int f = n; f >= 2; f--)
+	{
+		while ((n % f) == 0)
+		{
+			int prime = 1;
+
+			for (int d = 2; d*d <= f; d++)
+			{
+				if ((f % d) == 0)
+					prime = 0;
+			}
+
+			if (!prime)
+				break;
+
+			axis = 0;
+			for (int a = 1; a < ndims; a++)
+			{
+				if (grid.dims[a] < grid.dims[axis])
+					axis = a;
+			}
+
+			grid.dims[axis] *= f;
+			n /= f;
+		}
+	}
+}
+
+/**
+ * @brief Sets up the logical grid and the local tile.
+ *
+ * @param ndims Number of dimensions.
+ */
+static void grid_setup(int ndims)
+{
+	int me;
+	int rank;
+	int c[NDIMS_MAX];
+
+	me = knode_get_num() - PROCESSOR_NODENUM_LEADER;
+
+	grid.ndims = ndims;
+	grid_factor(NANVIX_PROC_MAX, ndims);
+
+	grid.coords[0] = me % grid.dims[0];
+	grid.coords[1] = (me/grid.dims[0]) % grid.dims[1];
+	grid.coords[2] = me/(grid.dims[0]*grid.dims[1]);
+
+	for (int a = 0; a < NDIMS_MAX; a++)
+	{
+		grid.tile[a] = (a < ndims) ? ((ndims == 2) ? TILE_2D : TILE_3D) : 1;
+		grid.offset[a] = (a < ndims) ? 1 : 0;
+		grid.extent[a] = grid.tile[a] + 2*grid.offset[a];
+	}
+
+	for (int a = 0; a < NDIMS_MAX; a++)
+		grid.facesize[a] = (grid.tile[0]*grid.tile[1]*grid.tile[2])/grid.tile[a];
+
+	/* Neighbors in a torus. */
+	for (int a = 0; a < ndims; a++)
+	{
+		for (int up = 0; up < 2; up++)
+		{
+			for (int b = 0; b < NDIMS_MAX; b++)
+				c[b] = grid.coords[b];
+
+			c[a] = (c[a] + (up ? 1 : -1) + grid.dims[a]) % grid.dims[a];
+			rank = c[0] + grid.dims[0]*(c[1] + grid.dims[1]*c[2]);
+
+			grid.neighbors[DIRECTION(a, up)] = rank;
+		}
+	}
+
+	for (int i = 0; i < GRID_MAX; i++)
+		tiles[0][i] = tiles[1][i] = (float) me;
+}
+
+/**
+ * @brief Copies a layer of a tile to or from a buffer.
+ *
+ * @param tile  Target tile.
+ * @param axis  Axis normal to the layer.
+ * @param layer Coordinate of the layer along @p axis (-1 for the low halo).
+ * @param buf   Target buffer.
+ * @param pack  Copy from the tile to the buffer?
+ */
+static void layer_copy(float *tile, int axis, int layer, float *buf, int pack)
+{
+	int n = 0;
+	int lo[NDIMS_MAX], hi[NDIMS_MAX];
+
+	for (int a = 0; a < NDIMS_MAX; a++)
+	{
+		lo[a] = (a == axis) ? layer : 0;
+		hi[a] = (a == axis) ? layer + 1 : grid.tile[a];
+	}
+
+	for (int z = lo[2]; z < hi[2]; z++)
+	{
+		for (int y = lo[1]; y < hi[1]; y++)
+		{
+			for (int x = lo[0]; x < hi[0]; x++)
+			{
+				if (pack)
+					buf[n++] = tile[cell(x, y, z)];
+				else
+					tile[cell(x, y, z)] = buf[n++];
+			}
+		}
+	}
+}
+
+/**
+ * @brief Runs Jacobi sweeps over a region of the tile.
+ *
+ * @param src    Source tile.
+ * @param dst    Target tile.
+ * @param region Region of the tile (see REGION_*).
+ */
+static void jacobi(const float *src, float *dst, int region)
+{
+	int boundary;
+	int c;
+	float sum;
+	int stride[NDIMS_MAX];
+	float scale;
+
+	stride[0] = 1;
+	stride[1] = grid.extent[0];
+	stride[2] = grid.extent[0]*grid.extent[1];
+	scale = 1.0f/(2*grid.ndims);
+
+	for (int s = 0; s < JACOBI_SWEEPS; s++)
+	{
+		for (int z = 0; z < grid.tile[2]; z++)
+		{
+			for (int y = 0; y < grid.tile[1]; y++)
+			{
+				for (int x = 0; x < grid.tile[0]; x++)
+				{
+					if (region != REGION_ALL)
+					{
+						boundary =
+							(x == 0) || (x == grid.tile[0] - 1) ||
+							(y == 0) || (y == grid.tile[1] - 1) ||
+							((grid.ndims == 3) && ((z == 0) || (z == grid.tile[2] - 1)));
+
+						if (boundary != (region == REGION_BOUNDARY))
+							continue;
+					}
+
+					c = cell(x, y, z);
+					sum = 0.0f;
+					for (int a = 0; a < grid.ndims; a++)
+						sum += src[c - stride[a]] + src[c + stride[a]];
+
+					dst[c] = sum*scale;
+				}
+			}
+		}
+	}
+}
+
+/**
+ * @brief Opens portals to the neighbors.
+ */
+static void halo_open(void)
+{
+	int dir;
+
+	for (int a = 0; a < grid.ndims; a++)
+	{
+		if (grid.dims[a] == 1)
+			continue;
+
+		for (int up = 0; up < 2; up++)
+		{
+			dir = DIRECTION(a, up);
+
+			uassert((
+				inportals[dir] = kportal_create(
+					knode_get_num(),
+					PORT_BASE + dir
+				)) >= 0
+			);
+
+			/* The face sent in this direction is the opposite halo of the neighbor. */
+			uassert((
+				outportals[dir] = kportal_open(
+					knode_get_num(),
+					PROCESSOR_NODENUM_LEADER + grid.neighbors[dir],
+					PORT_BASE + OPPOSITE(dir)
+				)) >= 0
+			);
+		}
+	}
+}
+
+/**
+ * @brief Closes portals to the neighbors.
+ */
+static void halo_close(void)
+{
+	int dir;
+
+	for (int a = 0; a < grid.ndims; a++)
+	{
+		if (grid.dims[a] == 1)
+			continue;
+
+		for (int up = 0; up < 2; up++)
+		{
+			dir = DIRECTION(a, up);
+
+			uassert(kportal_close(outportals[dir]) == 0);
+			uassert(kportal_unlink(inportals[dir]) == 0);
+		}
+	}
+}
+
+/**
+ * @brief Starts a halo exchange.
+ *
+ * Faces are packed and sent asynchronously, and halos are received
+ * asynchronously. Axes with a single node wrap around locally.
+ */
+static void halo_start(float *tile)
+{
+	int dir;
+	size_t size;
+
+	for (int a = 0; a < grid.ndims; a++)
+	{
+		size = grid.facesize[a]*sizeof(float);
+
+		for (int up = 0; up < 2; up++)
+		{
+			dir = DIRECTION(a, up);
+
+			layer_copy(tile, a, up ? grid.tile[a] - 1 : 0, sendbufs[dir], 1);
+
+			if (grid.dims[a] == 1)
+				continue;
+
+			uassert(kportal_allow(
+				inportals[dir],
+				PROCESSOR_NODENUM_LEADER + grid.neighbors[dir],
+				PORT_BASE + dir) == 0
+			);
+			uassert(kportal_aread(inportals[dir], recvbufs[dir], size) == (ssize_t) size);
+			uassert(kportal_awrite(outportals[dir], sendbufs[dir], size) == (ssize_t) size);
+		}
+	}
+}
+
+/**
+ * @brief Completes a halo exchange.
+ */
+static void halo_finish(float *tile)
+{
+	int dir;
+
+	for (int a = 0; a < grid.ndims; a++)
+	{
+		for (int up = 0; up < 2; up++)
+		{
+			dir = DIRECTION(a, up);
+
+			/* Periodic halo of an axis with a single node. */
+			if (grid.dims[a] == 1)
+			{
+				layer_copy(tile, a, up ? grid.tile[a] : -1, sendbufs[OPPOSITE(dir)], 0);
+				continue;
+			}
+
+			uassert(kportal_wait(outportals[dir]) == 0);
+			uassert(kportal_wait(inportals[dir]) == 0);
+
+			layer_copy(tile, a, up ? grid.tile[a] : -1, recvbufs[dir], 0);
+		}
+	}
+}
+
+/**
+ * @brief Runs the halo exchange.
+ *
+ * @param ndims Number of dimensions.
+ */
+static void benchmark_halo(int ndims)
+{
+	int cur;
+	uint64_t t0, t1, t2;
+	uint64_t comm, compute, iter;
+	uint64_t tcomm, tcomp, titer;
+	int64_t overlap;
+	char variant[BENCHMARK_VARIANT_MAX];
+	char summary[BENCHMARK_VARIANT_MAX];
+
+	grid_setup(ndims);
+	halo_open();
+
+	usprintf(summary, "halo:dims=%d,grid=%dx%dx%d,tile=%d,sweeps=%d",
+		ndims,
+		grid.dims[0], grid.dims[1], grid.dims[2],
+		grid.tile[0],
+		JACOBI_SWEEPS
+	);
+
+	tcomm = tcomp = titer = 0;
+	cur = 0;
+
+	/* Exchange halos, then compute. */
+	usprintf(variant, "%s,mode=blocking", summary);
+	for (int i = 1; i <= NITERATIONS; i++)
+	{
+		uassert(barrier_wait(barrier) == 0);
+
+		kclock(&t0);
+			halo_start(tiles[cur]);
+			halo_finish(tiles[cur]);
+		kclock(&t1);
+			jacobi(tiles[cur], tiles[cur ^ 1], REGION_ALL);
+		kclock(&t2);
+
+		cur ^= 1;
+
+		comm = benchmark_elapsed(t0, t1);
+		compute = benchmark_elapsed(t1, t2);
+		tcomm += comm;
+		tcomp += compute;
+
+		benchmark_record_time("cargo", variant, i, "iteration", comm + compute);
+		benchmark_record_time("cargo", variant, i, "comm", comm);
+		benchmark_record_time("cargo", variant, i, "compute", compute);
+	}
+
+	/* Compute interior while exchanging halos. */
+	usprintf(variant, "%s,mode=overlap", summary);
+	for (int i = 1; i <= NITERATIONS; i++)
+	{
+		uassert(barrier_wait(barrier) == 0);
+
+		kclock(&t0);
+			halo_start(tiles[cur]);
+			jacobi(tiles[cur], tiles[cur ^ 1], REGION_INTERIOR);
+			halo_finish(tiles[cur]);
+			jacobi(tiles[cur], tiles[cur ^ 1], REGION_BOUNDARY);
+		kclock(&t1);
+
+		cur ^= 1;
+
+		iter = benchmark_elapsed(t0, t1);
+		titer += iter;
+
+		benchmark_record_time("cargo", variant, i, "iteration", iter);
+	}
+
+	/*
+	 * Fraction of communication hidden behind computation:
+	 * (Tcomm + Tcomp - Titer)/Tcomm, in thousandths.
+	 */
+	if (tcomm > 0)
+	{
+		overlap = ((int64_t) (tcomm + tcomp) - (int64_t) titer)*1000/((int64_t) tcomm);
+		overlap = (overlap < 0) ? 0 : ((overlap > 1000) ? 1000 : overlap);
+
+		benchmark_record("cargo", summary, 0, "overlap", (uint64_t) overlap, BENCHMARK_UNIT_PERMILLE);
+	}
+
+	uassert(barrier_wait(barrier) == 0);
+
+	halo_close();
+}
+
+/**
+ * @brief Benchmarks nearest-neighbor halo exchanges with portals.
+ */
+static void benchmark_cargo_halo(void)
+{
+	/* Build list of nodes. */
+	for (int i = 0; i < NANVIX_PROC_MAX; i++)
+		nodes[i] = PROCESSOR_NODENUM_LEADER + i;
+
+	barrier = barrier_create(nodes, NANVIX_PROC_MAX);
+	uassert(BARRIER_IS_VALID(barrier));
+
+		benchmark_halo(2);
+		benchmark_halo(3);
+
+	uassert(barrier_destroy(barrier) == 0);
+}
+
+/*============================================================================*
+ * Benchmark Driver                                                           *
+ *============================================================================*/
+
+/**
+ * @brief Launches a benchmark.
+ */
+int __main3(int argc, const char *argv[])
+{
+	((void) argc);
+	((void) argv);
+
+	benchmark_calibrate();
+
+	benchmark_cargo_halo();
+
+	return (0);
+}
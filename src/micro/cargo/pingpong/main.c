@@ -26,6 +26,11 @@
 #include <nanvix/sys/perf.h>
 #include <nanvix/limits.h>
 #include <nanvix/ulib.h>
+#include <benchmark/record.h>
+#include <benchmark/units.h>
+#include <benchmark/perf.h>
+#include <benchmark/calibration.h>
+#include <benchmark/trace.h>
 
 /**
  * @brief Number of iterations for the benchmark.
@@ -62,6 +67,7 @@ static void do_leader(void)
 {
 	int inportal, outportal;
 	uint64_t latency, volume;
+	struct benchmark_perf perf;
 
 	/* Establish connection. */
 	uassert((inportal = kportal_create(knode_get_num(), PORT_NUM)) >= 0);
@@ -69,23 +75,27 @@ static void do_leader(void)
 
 	for (int i = 1; i <= NITERATIONS; i++)
 	{
-		uassert(kportal_allow(inportal, PROCESSOR_NODENUM_LEADER + 1, PORT_NUM) == 0);
-		uassert(kportal_read(inportal, buf, BUFFER_SIZE) == BUFFER_SIZE);
-		uassert(kportal_write(outportal, buf, BUFFER_SIZE) == BUFFER_SIZE);
+		/* Tracing stays out of the measured region. */
+		benchmark_trace_begin(BENCHMARK_TRACE_EXCHANGE, PROCESSOR_NODENUM_LEADER + 1, 2*BUFFER_SIZE);
+		benchmark_perf_start(&perf);
+			uassert(kportal_allow(inportal, PROCESSOR_NODENUM_LEADER + 1, PORT_NUM) == 0);
+			uassert(kportal_read(inportal, buf, BUFFER_SIZE) == BUFFER_SIZE);
+			uassert(kportal_write(outportal, buf, BUFFER_SIZE) == BUFFER_SIZE);
+		benchmark_perf_stop(&perf);
+		benchmark_trace_end(BENCHMARK_TRACE_EXCHANGE, PROCESSOR_NODENUM_LEADER + 1, 2*BUFFER_SIZE);
 
 		uassert(kportal_ioctl(inportal, KPORTAL_IOCTL_GET_LATENCY, &latency) == 0);
 		uassert(kportal_ioctl(inportal, KPORTAL_IOCTL_GET_VOLUME, &volume) == 0);
 
 		/* Dump statistics. */
-#ifndef NDEBUG
-		uprintf("[benchmarks][cargo][pingpong] it=%d latency=%l volume=%l",
-#else
-		uprintf("cargo;pingpong;%d;%l;%l",
-#endif
-			i, latency, volume
-		);
+		benchmark_record_time("cargo", "pingpong", i, "latency", latency);
+		benchmark_record("cargo", "pingpong", i, "volume", volume, BENCHMARK_UNIT_BYTES);
+		benchmark_record_bandwidth("cargo", "pingpong", i, "bandwidth", volume, latency);
+		benchmark_perf_record("cargo", "pingpong", i, "exchange", &perf, 2*BUFFER_SIZE);
 	}
 
+	benchmark_trace_dump("cargo", "pingpong");
+
 	/* House keeping. */
 	uassert(kportal_close(outportal) == 0);
 	uassert(kportal_unlink(inportal) == 0);
@@ -104,11 +114,18 @@ static void do_worker(void)
 
 	for (int i = 1; i <= NITERATIONS; i++)
 	{
+		benchmark_trace_begin(BENCHMARK_TRACE_SEND, PROCESSOR_NODENUM_LEADER, BUFFER_SIZE);
 		uassert(kportal_write(outportal, buf, BUFFER_SIZE) == BUFFER_SIZE);
+		benchmark_trace_end(BENCHMARK_TRACE_SEND, PROCESSOR_NODENUM_LEADER, BUFFER_SIZE);
 		uassert(kportal_allow(inportal, PROCESSOR_NODENUM_LEADER, PORT_NUM) == 0);
+		benchmark_trace(BENCHMARK_TRACE_ALLOW, BENCHMARK_TRACE_INSTANT, PROCESSOR_NODENUM_LEADER, BUFFER_SIZE);
+		benchmark_trace_begin(BENCHMARK_TRACE_READ, PROCESSOR_NODENUM_LEADER, BUFFER_SIZE);
 		uassert(kportal_read(inportal, buf,  BUFFER_SIZE) == BUFFER_SIZE);
+		benchmark_trace_end(BENCHMARK_TRACE_READ, PROCESSOR_NODENUM_LEADER, BUFFER_SIZE);
 	}
 
+	benchmark_trace_dump("cargo", "pingpong");
+
 	/* House keeping. */
 	uassert(kportal_close(outportal) == 0);
 	uassert(kportal_unlink(inportal) == 0);
@@ -139,6 +156,8 @@ int __main3(int argc, const char *argv[])
 	((void) argc);
 	((void) argv);
 
+	benchmark_calibrate();
+
 	benchmark_cargo_pingpong();
 
 	return (0);
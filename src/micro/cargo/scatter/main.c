@@ -0,0 +1,289 @@
+/*
+ * MIT License
+ *
+ * Copyright(c) 2011-2020 The Maintainers of Nanvix
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <nanvix/runtime/runtime.h>
+#include <nanvix/runtime/barrier.h>
+#include <nanvix/sys/perf.h>
+#include <nanvix/limits.h>
+#include <nanvix/ulib.h>
+#include <benchmark/record.h>
+#include <benchmark/units.h>
+#include <benchmark/calibration.h>
+
+/**
+ * @brief Number of iterations for the benchmark.
+ */
+#ifdef NDEBUG
+#define NITERATIONS 30
+#else
+#define NITERATIONS 1
+#endif
+
+static barrier_t barrier;
+static int nodes[NANVIX_PROC_MAX];
+
+/*============================================================================*
+ * Benchmark Kernel                                                           *
+ *============================================================================*/
+
+/**
+ * @brief Smallest block size (in bytes).
+ */
+#ifndef BLOCK_SIZE_MIN
+#define BLOCK_SIZE_MIN 512
+#endif
+
+/**
+ * @brief Largest block size (in bytes).
+ */
+#ifndef BLOCK_SIZE_MAX
+#define BLOCK_SIZE_MAX 4096
+#endif
+
+/**
+ * @brief Port number used in the benchmark.
+ */
+#define PORT_NUM 0
+
+/**
+ * @name Algorithms
+ */
+/**@{*/
+#define ALGORITHM_FLAT      0 /**< Flat.               */
+#define ALGORITHM_RING      1 /**< Ring.               */
+#define ALGORITHM_RECURSIVE 2 /**< Recursive doubling. */
+#define ALGORITHMS_NUM      3 /**< Number of algorithms. */
+/**@}*/
+
+/**
+ * @brief Names of algorithms.
+ */
+static const char *algorithms[ALGORITHMS_NUM] = { "flat", "ring", "recursive" };
+
+/**
+ * @brief Portals.
+ */
+/**@{*/
+static int inportal;
+static int outportals[NANVIX_PROC_MAX];
+/**@}*/
+
+/**
+ * @brief Buffer holding the blocks of all nodes.
+ */
+static char buffer[NANVIX_PROC_MAX*BLOCK_SIZE_MAX];
+
+/**
+ * @brief Sends data to a node.
+ */
+static void do_send(int to, const char *buf, size_t size)
+{
+	uassert(kportal_write(outportals[to], buf, size) == (ssize_t) size);
+}
+
+/**
+ * @brief Receives data from a node.
+ */
+static void do_recv(int from, char *buf, size_t size)
+{
+	uassert(kportal_allow(inportal, PROCESSOR_NODENUM_LEADER + from, PORT_NUM) == 0);
+	uassert(kportal_read(inportal, buf, size) == (ssize_t) size);
+}
+
+/**
+ * @brief Flat scatter: the root sends each block straight to its owner.
+ */
+static void scatter_flat(int me, int nnodes, size_t block)
+{
+	if (me == 0)
+	{
+		for (int i = 1; i < nnodes; i++)
+			do_send(i, &buffer[i*block], block);
+	}
+	else
+		do_recv(0, &buffer[me*block], block);
+}
+
+/**
+ * @brief Ring scatter: each node keeps its block and forwards the rest
+ * to the next node.
+ */
+static void scatter_ring(int me, int nnodes, size_t block)
+{
+	if (me > 0)
+		do_recv(me - 1, &buffer[me*block], (nnodes - me)*block);
+
+	if (me < (nnodes - 1))
+		do_send(me + 1, &buffer[(me + 1)*block], (nnodes - me - 1)*block);
+}
+
+/**
+ * @brief Recursive-halving scatter: at each step, nodes that hold data
+ * send the upper half of it to a node that is half as far away.
+ */
+static void scatter_recursive(int me, int nnodes, size_t block)
+{
+	for (int mask = nnodes/2; mask >= 1; mask >>= 1)
+	{
+		if ((me % (2*mask)) == 0)
+			do_send(me + mask, &buffer[(me + mask)*block], mask*block);
+		else if ((me % (2*mask)) == mask)
+			do_recv(me - mask, &buffer[me*block], mask*block);
+	}
+}
+
+/**
+ * @brief Scatter algorithms.
+ */
+static void (*scatter_fns[ALGORITHMS_NUM])(int, int, size_t) = {
+	scatter_flat,
+	scatter_ring,
+	scatter_recursive
+};
+
+/**
+ * @brief Runs a scatter.
+ *
+ * @param algorithm Algorithm.
+ * @param nnodes    Number of nodes.
+ * @param block     Block size (in bytes).
+ */
+static void benchmark_scatter(int algorithm, int nnodes, size_t block)
+{
+	int me;
+	uint64_t t0, t1;
+	uint64_t local0, local1;
+	char variant[BENCHMARK_VARIANT_MAX];
+
+	me = knode_get_num() - PROCESSOR_NODENUM_LEADER;
+
+	usprintf(variant, "scatter:algo=%s,block=%d,nodes=%d",
+		algorithms[algorithm],
+		(int) block,
+		nnodes
+	);
+
+	for (int i = 1; i <= NITERATIONS; i++)
+	{
+		/* Root owns all blocks, block j is filled with j. */
+		if (me == 0)
+		{
+			for (int j = 0; j < nnodes; j++)
+				umemset(&buffer[j*block], j, block);
+		}
+		else
+			umemset(&buffer[me*block], 0xff, block);
+
+		uassert(barrier_wait(barrier) == 0);
+		kclock(&t0);
+
+			kclock(&local0);
+			if (me < nnodes)
+				scatter_fns[algorithm](me, nnodes, block);
+			kclock(&local1);
+
+		uassert(barrier_wait(barrier) == 0);
+		kclock(&t1);
+
+		if (me >= nnodes)
+			continue;
+
+		uassert(buffer[me*block] == me);
+		uassert(buffer[(me + 1)*block - 1] == me);
+
+		/* Dump statistics. */
+		benchmark_record_time("cargo", variant, i, "local", benchmark_elapsed(local0, local1));
+		if (me == 0)
+		{
+			benchmark_record_time("cargo", variant, i, "completion", benchmark_elapsed(t0, t1));
+			benchmark_record_bandwidth("cargo", variant, i, "bandwidth",
+				(nnodes - 1)*block,
+				benchmark_elapsed(t0, t1)
+			);
+		}
+	}
+}
+
+/**
+ * @brief Benchmarks scatter communication with portals.
+ */
+static void benchmark_cargo_scatter(void)
+{
+	int me;
+
+	me = knode_get_num() - PROCESSOR_NODENUM_LEADER;
+
+	/* Build list of nodes. */
+	for (int i = 0; i < NANVIX_PROC_MAX; i++)
+		nodes[i] = PROCESSOR_NODENUM_LEADER + i;
+
+	barrier = barrier_create(nodes, NANVIX_PROC_MAX);
+	uassert(BARRIER_IS_VALID(barrier));
+
+	/* Establish connections. */
+	uassert((inportal = kportal_create(knode_get_num(), PORT_NUM)) >= 0);
+	for (int i = 0; i < NANVIX_PROC_MAX; i++)
+	{
+		if (i != me)
+			uassert((outportals[i] = kportal_open(knode_get_num(), nodes[i], PORT_NUM)) >= 0);
+	}
+
+		for (int nnodes = 2; nnodes <= NANVIX_PROC_MAX; nnodes *= 2)
+		{
+			for (size_t block = BLOCK_SIZE_MIN; block <= BLOCK_SIZE_MAX; block *= 2)
+			{
+				for (int algorithm = 0; algorithm < ALGORITHMS_NUM; algorithm++)
+					benchmark_scatter(algorithm, nnodes, block);
+			}
+		}
+
+	/* House keeping. */
+	for (int i = 0; i < NANVIX_PROC_MAX; i++)
+	{
+		if (i != me)
+			uassert(kportal_close(outportals[i]) == 0);
+	}
+	uassert(kportal_unlink(inportal) == 0);
+
+	uassert(barrier_destroy(barrier) == 0);
+}
+
+/*============================================================================*
+ * Benchmark Driver                                                           *
+ *============================================================================*/
+
+/**
+ * @brief Launches a benchmark.
+ */
+int __main3(int argc, const char *argv[])
+{
+	((void) argc);
+	((void) argv);
+
+	benchmark_calibrate();
+
+	benchmark_cargo_scatter();
+
+	return (0);
+}
@@ -25,6 +25,9 @@
 #include <nanvix/runtime/runtime.h>
 #include <nanvix/sys/perf.h>
 #include <nanvix/ulib.h>
+#include <benchmark/record.h>
+#include <benchmark/perf.h>
+#include <benchmark/calibration.h>
 
 /*============================================================================*
  * Benchmark                                                                  *
@@ -32,23 +35,19 @@
 
 /**
  * @brief Hello world micro-benchmark.
+ *
+ * Measures an empty region. Once measurement overhead is calibrated,
+ * this should report (nearly) zero cycles.
  */
 static void benchmark_hello(void)
 {
-	uint64_t time_hello;
+	struct benchmark_perf perf_hello;
 
 	/* Allocate memory .*/
-	perf_start(0, PERF_CYCLES);
-	perf_stop(0);
-	time_hello = perf_read(0);
+	benchmark_perf_start(&perf_hello);
+	benchmark_perf_stop(&perf_hello);
 
-#ifndef NDEBUG
-	uprintf("[benchmarks][hello] hello takes %l",
-#else
-	uprintf("[benchmarks][hello] %ll",
-#endif
-		time_hello
-	);
+	benchmark_perf_record("hello", "empty", 0, "time", &perf_hello, 0);
 }
 
 /*============================================================================*
@@ -63,6 +62,8 @@ int __main3(int argc, const char *argv[])
 	((void) argc);
 	((void) argv);
 
+	benchmark_calibrate();
+
 	benchmark_hello();
 
 	return (0);
@@ -27,6 +27,11 @@
 #include <nanvix/sys/perf.h>
 #include <nanvix/limits.h>
 #include <nanvix/ulib.h>
+#include <benchmark/record.h>
+#include <benchmark/units.h>
+#include <benchmark/calibration.h>
+#include <benchmark/trace.h>
+#include <benchmark/traffic.h>
 
 /**
  * @brief Number of iterations for the benchmark.
@@ -59,19 +64,25 @@ static char msg[KMAILBOX_MESSAGE_SIZE];
  */
 static void do_leader(void)
 {
+	uint64_t t0;
 	int outboxes[NANVIX_PROC_MAX - 1];
 
 	/* Establish connections. */
 	for (int i = 1; i < NANVIX_PROC_MAX; i++)
 		uassert((outboxes[i - 1] = kmailbox_open(PROCESSOR_NODENUM_LEADER + i, PORT_NUM)) >= 0);
 
+	benchmark_trace_begin(BENCHMARK_TRACE_BARRIER, -1, 0);
 	uassert(barrier_wait(barrier) == 0);
+	benchmark_trace_end(BENCHMARK_TRACE_BARRIER, -1, 0);
+	benchmark_trace_sync();
 
 	/* Broadcast messages. */
 	for (int k = 1; k <= NITERATIONS; k++)
 	{
 		for (int i = 1; i < NANVIX_PROC_MAX; i++)
 		{
+			benchmark_trace_begin(BENCHMARK_TRACE_SEND, PROCESSOR_NODENUM_LEADER + i, KMAILBOX_MESSAGE_SIZE);
+			t0 = benchmark_traffic_clock();
 			uassert(
 				kmailbox_write(
 					outboxes[i - 1],
@@ -79,10 +90,17 @@ static void do_leader(void)
 					KMAILBOX_MESSAGE_SIZE
 				) == KMAILBOX_MESSAGE_SIZE
 			);
+			benchmark_traffic_account(BENCHMARK_TRAFFIC_SEND, PROCESSOR_NODENUM_LEADER + i, KMAILBOX_MESSAGE_SIZE, t0);
+			benchmark_trace_end(BENCHMARK_TRACE_SEND, PROCESSOR_NODENUM_LEADER + i, KMAILBOX_MESSAGE_SIZE);
 		}
 	}
 
+	benchmark_trace_begin(BENCHMARK_TRACE_BARRIER, -1, 0);
 	uassert(barrier_wait(barrier) == 0);
+	benchmark_trace_end(BENCHMARK_TRACE_BARRIER, -1, 0);
+
+	benchmark_trace_dump("mail", "broadcast");
+	benchmark_traffic_dump("mail", "broadcast");
 
 	/* House keeping. */
 	for (int i = 1; i < NANVIX_PROC_MAX; i++)
@@ -95,15 +113,21 @@ static void do_leader(void)
 static void do_worker(void)
 {
 	int inbox;
+	uint64_t t0;
 	uint64_t latency, volume;
 
 	/* Establish connection. */
 	uassert((inbox = kmailbox_create(knode_get_num(), PORT_NUM)) >= 0);
 
+	benchmark_trace_begin(BENCHMARK_TRACE_BARRIER, -1, 0);
 	uassert(barrier_wait(barrier) == 0);
+	benchmark_trace_end(BENCHMARK_TRACE_BARRIER, -1, 0);
+	benchmark_trace_sync();
 
 	for (int i = 1; i <= NITERATIONS; i++)
 	{
+			benchmark_trace_begin(BENCHMARK_TRACE_READ, PROCESSOR_NODENUM_LEADER, KMAILBOX_MESSAGE_SIZE);
+			t0 = benchmark_traffic_clock();
 			uassert(
 				kmailbox_read(
 					inbox,
@@ -111,21 +135,24 @@ static void do_worker(void)
 					KMAILBOX_MESSAGE_SIZE
 				) == KMAILBOX_MESSAGE_SIZE
 			);
+			benchmark_traffic_account(BENCHMARK_TRAFFIC_RECV, PROCESSOR_NODENUM_LEADER, KMAILBOX_MESSAGE_SIZE, t0);
+			benchmark_trace_end(BENCHMARK_TRACE_READ, PROCESSOR_NODENUM_LEADER, KMAILBOX_MESSAGE_SIZE);
 		
 		uassert(kmailbox_ioctl(inbox, KMAILBOX_IOCTL_GET_LATENCY, &latency) == 0);
 		uassert(kmailbox_ioctl(inbox, KMAILBOX_IOCTL_GET_VOLUME, &volume) == 0);
 
 		/* Dump statistics. */
-#ifndef NDEBUG
-		uprintf("[benchmarks][mail][broadcast] it=%d latency=%l volume=%l",
-#else
-		uprintf("mailbox;broadcast;%d;%l;%l",
-#endif
-			i, latency, volume
-		);
+		benchmark_record_time("mail", "broadcast", i, "latency", latency);
+		benchmark_record("mail", "broadcast", i, "volume", volume, BENCHMARK_UNIT_BYTES);
+		benchmark_record_bandwidth("mail", "broadcast", i, "bandwidth", volume, latency);
 	}
 
+	benchmark_trace_begin(BENCHMARK_TRACE_BARRIER, -1, 0);
 	uassert(barrier_wait(barrier) == 0);
+	benchmark_trace_end(BENCHMARK_TRACE_BARRIER, -1, 0);
+
+	benchmark_trace_dump("mail", "broadcast");
+	benchmark_traffic_dump("mail", "broadcast");
 
 	/* House keeping. */
 	uassert(kmailbox_unlink(inbox) == 0);
@@ -165,6 +192,8 @@ int __main3(int argc, const char *argv[])
 	((void) argc);
 	((void) argv);
 
+	benchmark_calibrate();
+
 	benchmark_mail_broadcast();
 
 	return (0);
@@ -27,6 +27,11 @@
 #include <nanvix/sys/perf.h>
 #include <nanvix/limits.h>
 #include <nanvix/ulib.h>
+#include <benchmark/record.h>
+#include <benchmark/units.h>
+#include <benchmark/calibration.h>
+#include <benchmark/trace.h>
+#include <benchmark/traffic.h>
 
 /**
  * @brief Number of iterations for the benchmark.
@@ -60,18 +65,24 @@ static char msg[KMAILBOX_MESSAGE_SIZE];
 static void do_leader(void)
 {
 	int inbox;
+	uint64_t t0;
 	uint64_t latency, volume;
 
 	/* Establish connection. */
 	uassert((inbox = kmailbox_create(knode_get_num(), PORT_NUM)) >= 0);
 
+	benchmark_trace_begin(BENCHMARK_TRACE_BARRIER, -1, 0);
 	uassert(barrier_wait(barrier) == 0);
+	benchmark_trace_end(BENCHMARK_TRACE_BARRIER, -1, 0);
+	benchmark_trace_sync();
 
 	/* Broadcast messages. */
 	for (int k = 1; k <= NITERATIONS; k++)
 	{
 		for (int i = 1; i < NANVIX_PROC_MAX; i++)
 		{
+			benchmark_trace_begin(BENCHMARK_TRACE_READ, -1, KMAILBOX_MESSAGE_SIZE);
+			t0 = benchmark_traffic_clock();
 			uassert(
 				kmailbox_read(
 					inbox,
@@ -79,22 +90,25 @@ static void do_leader(void)
 					KMAILBOX_MESSAGE_SIZE
 				) == KMAILBOX_MESSAGE_SIZE
 			);
+			benchmark_traffic_account(BENCHMARK_TRAFFIC_RECV, -1, KMAILBOX_MESSAGE_SIZE, t0);
+			benchmark_trace_end(BENCHMARK_TRACE_READ, -1, KMAILBOX_MESSAGE_SIZE);
 		}
 
 		uassert(kmailbox_ioctl(inbox, KMAILBOX_IOCTL_GET_LATENCY, &latency) == 0);
 		uassert(kmailbox_ioctl(inbox, KMAILBOX_IOCTL_GET_VOLUME, &volume) == 0);
 
 		/* Dump statistics. */
-#ifndef NDEBUG
-		uprintf("[benchmarks][mail][gather] it=%d latency=%l volume=%l",
-#else
-		uprintf("mailbox;gather;%d;%l;%l",
-#endif
-			k, latency, volume
-		);
+		benchmark_record_time("mail", "gather", k, "latency", latency);
+		benchmark_record("mail", "gather", k, "volume", volume, BENCHMARK_UNIT_BYTES);
+		benchmark_record_bandwidth("mail", "gather", k, "bandwidth", volume, latency);
 	}
 
+	benchmark_trace_begin(BENCHMARK_TRACE_BARRIER, -1, 0);
 	uassert(barrier_wait(barrier) == 0);
+	benchmark_trace_end(BENCHMARK_TRACE_BARRIER, -1, 0);
+
+	benchmark_trace_dump("mail", "gather");
+	benchmark_traffic_dump("mail", "gather");
 
 	/* House keeping. */
 	uassert(kmailbox_unlink(inbox) == 0);
@@ -106,14 +120,20 @@ static void do_leader(void)
 static void do_worker(void)
 {
 	int outbox;
+	uint64_t t0;
 
 	/* Establish connection. */
 	uassert((outbox = kmailbox_open(PROCESSOR_NODENUM_LEADER, PORT_NUM)) >= 0);
 
+	benchmark_trace_begin(BENCHMARK_TRACE_BARRIER, -1, 0);
 	uassert(barrier_wait(barrier) == 0);
+	benchmark_trace_end(BENCHMARK_TRACE_BARRIER, -1, 0);
+	benchmark_trace_sync();
 
 	for (int i = 1; i <= NITERATIONS; i++)
 	{
+			benchmark_trace_begin(BENCHMARK_TRACE_SEND, PROCESSOR_NODENUM_LEADER, KMAILBOX_MESSAGE_SIZE);
+			t0 = benchmark_traffic_clock();
 			uassert(
 				kmailbox_write(
 					outbox,
@@ -121,9 +141,16 @@ static void do_worker(void)
 					KMAILBOX_MESSAGE_SIZE
 				) == KMAILBOX_MESSAGE_SIZE
 			);
+			benchmark_traffic_account(BENCHMARK_TRAFFIC_SEND, PROCESSOR_NODENUM_LEADER, KMAILBOX_MESSAGE_SIZE, t0);
+			benchmark_trace_end(BENCHMARK_TRACE_SEND, PROCESSOR_NODENUM_LEADER, KMAILBOX_MESSAGE_SIZE);
 	}
 
+	benchmark_trace_begin(BENCHMARK_TRACE_BARRIER, -1, 0);
 	uassert(barrier_wait(barrier) == 0);
+	benchmark_trace_end(BENCHMARK_TRACE_BARRIER, -1, 0);
+
+	benchmark_trace_dump("mail", "gather");
+	benchmark_traffic_dump("mail", "gather");
 
 	/* House keeping. */
 	uassert(kmailbox_close(outbox) == 0);
@@ -163,6 +190,8 @@ int __main3(int argc, const char *argv[])
 	((void) argc);
 	((void) argv);
 
+	benchmark_calibrate();
+
 	benchmark_mail_gather();
 
 	return (0);
@@ -27,6 +27,11 @@
 #include <nanvix/sys/perf.h>
 #include <nanvix/limits.h>
 #include <nanvix/ulib.h>
+#include <benchmark/record.h>
+#include <benchmark/units.h>
+#include <benchmark/perf.h>
+#include <benchmark/calibration.h>
+#include <benchmark/trace.h>
 
 /**
  * @brief Number of iterations for the benchmark.
@@ -61,32 +66,42 @@ static void do_leader(void)
 {
 	int inbox, outbox;
 	uint64_t latency, volume;
+	struct benchmark_perf perf;
 
 	/* Establish connection. */
 	uassert((inbox = kmailbox_create(knode_get_num(), PORT_NUM)) >= 0);
 	uassert((outbox = kmailbox_open(PROCESSOR_NODENUM_LEADER + 1, PORT_NUM)) >= 0);
 
+	benchmark_trace_begin(BENCHMARK_TRACE_BARRIER, -1, 0);
 	uassert(barrier_wait(barrier) == 0);
+	benchmark_trace_end(BENCHMARK_TRACE_BARRIER, -1, 0);
+	benchmark_trace_sync();
 
 	for (int i = 1; i <= NITERATIONS; i++)
 	{
-		uassert(kmailbox_read(inbox, msg, KMAILBOX_MESSAGE_SIZE) == KMAILBOX_MESSAGE_SIZE);
-		uassert(kmailbox_write(outbox, msg, KMAILBOX_MESSAGE_SIZE) == KMAILBOX_MESSAGE_SIZE);
+		/* Tracing stays out of the measured region. */
+		benchmark_trace_begin(BENCHMARK_TRACE_EXCHANGE, PROCESSOR_NODENUM_LEADER + 1, 2*KMAILBOX_MESSAGE_SIZE);
+		benchmark_perf_start(&perf);
+			uassert(kmailbox_read(inbox, msg, KMAILBOX_MESSAGE_SIZE) == KMAILBOX_MESSAGE_SIZE);
+			uassert(kmailbox_write(outbox, msg, KMAILBOX_MESSAGE_SIZE) == KMAILBOX_MESSAGE_SIZE);
+		benchmark_perf_stop(&perf);
+		benchmark_trace_end(BENCHMARK_TRACE_EXCHANGE, PROCESSOR_NODENUM_LEADER + 1, 2*KMAILBOX_MESSAGE_SIZE);
 
 		uassert(kmailbox_ioctl(inbox, KMAILBOX_IOCTL_GET_LATENCY, &latency) == 0);
 		uassert(kmailbox_ioctl(inbox, KMAILBOX_IOCTL_GET_VOLUME, &volume) == 0);
 
 		/* Dump statistics. */
-#ifndef NDEBUG
-		uprintf("[benchmarks][mail][pingpong] it=%d latency=%l volume=%l",
-#else
-		uprintf("mailbox;pingpong;%d;%l;%l",
-#endif
-			i, latency, volume
-		);
+		benchmark_record_time("mail", "pingpong", i, "latency", latency);
+		benchmark_record("mail", "pingpong", i, "volume", volume, BENCHMARK_UNIT_BYTES);
+		benchmark_record_bandwidth("mail", "pingpong", i, "bandwidth", volume, latency);
+		benchmark_perf_record("mail", "pingpong", i, "exchange", &perf, 2*KMAILBOX_MESSAGE_SIZE);
 	}
 
+	benchmark_trace_begin(BENCHMARK_TRACE_BARRIER, -1, 0);
 	uassert(barrier_wait(barrier) == 0);
+	benchmark_trace_end(BENCHMARK_TRACE_BARRIER, -1, 0);
+
+	benchmark_trace_dump("mail", "pingpong");
 
 	/* House keeping. */
 	uassert(kmailbox_close(outbox) == 0);
@@ -104,15 +119,26 @@ static void do_worker(void)
 	uassert((inbox = kmailbox_create(knode_get_num(), PORT_NUM)) >= 0);
 	uassert((outbox = kmailbox_open(PROCESSOR_NODENUM_LEADER, PORT_NUM)) >= 0);
 
+	benchmark_trace_begin(BENCHMARK_TRACE_BARRIER, -1, 0);
 	uassert(barrier_wait(barrier) == 0);
+	benchmark_trace_end(BENCHMARK_TRACE_BARRIER, -1, 0);
+	benchmark_trace_sync();
 
 	for (int i = 1; i <= NITERATIONS; i++)
 	{
+		benchmark_trace_begin(BENCHMARK_TRACE_SEND, PROCESSOR_NODENUM_LEADER, KMAILBOX_MESSAGE_SIZE);
 		uassert(kmailbox_write(outbox, msg, KMAILBOX_MESSAGE_SIZE) == KMAILBOX_MESSAGE_SIZE);
+		benchmark_trace_end(BENCHMARK_TRACE_SEND, PROCESSOR_NODENUM_LEADER, KMAILBOX_MESSAGE_SIZE);
+		benchmark_trace_begin(BENCHMARK_TRACE_READ, PROCESSOR_NODENUM_LEADER, KMAILBOX_MESSAGE_SIZE);
 		uassert(kmailbox_read(inbox, msg,  KMAILBOX_MESSAGE_SIZE) == KMAILBOX_MESSAGE_SIZE);
+		benchmark_trace_end(BENCHMARK_TRACE_READ, PROCESSOR_NODENUM_LEADER, KMAILBOX_MESSAGE_SIZE);
 	}
 
+	benchmark_trace_begin(BENCHMARK_TRACE_BARRIER, -1, 0);
 	uassert(barrier_wait(barrier) == 0);
+	benchmark_trace_end(BENCHMARK_TRACE_BARRIER, -1, 0);
+
+	benchmark_trace_dump("mail", "pingpong");
 
 	/* House keeping. */
 	uassert(kmailbox_close(outbox) == 0);
@@ -153,6 +179,8 @@ int __main3(int argc, const char *argv[])
 	((void) argc);
 	((void) argv);
 
+	benchmark_calibrate();
+
 	benchmark_mail_pingpong();
 
 	return (0);
@@ -25,6 +25,9 @@
 #include <nanvix/runtime/runtime.h>
 #include <nanvix/sys/perf.h>
 #include <nanvix/ulib.h>
+#include <benchmark/record.h>
+#include <benchmark/perf.h>
+#include <benchmark/calibration.h>
 
 /**
  * @brief Number of blocks to allocate.
@@ -46,18 +49,17 @@ static char buffer1[RMEM_BLOCK_SIZE];
 static void benchmark_memread(void)
 {
 	void *blks[NUM_PAGES];
-	uint64_t time_alloc, time_kernel, time_free;
+	struct benchmark_perf perf_alloc, perf_kernel, perf_free;
 
 	/* Allocate memory .*/
 #ifndef NDEBUG
 	uprintf("[benchmarks][memread] allocating memory...");
 #endif
-	perf_start(0, PERF_CYCLES);
+	benchmark_perf_start(&perf_alloc);
 		/* Allocate many blocks.*/
 		for (int i = 0; i < NUM_PAGES; i++)
 			uassert((blks[i] = nanvix_vmem_alloc(1)) != NULL);
-	perf_stop(0);
-	time_alloc = perf_read(0);
+	benchmark_perf_stop(&perf_alloc);
 
 	/* Warmup. */
 	for (int i = 0; i < NUM_PAGES; i++)
@@ -66,30 +68,22 @@ static void benchmark_memread(void)
 #ifndef NDEBUG
 	uprintf("[benchmarks][memread] benchmarking...");
 #endif
-	perf_start(0, PERF_CYCLES);
+	benchmark_perf_start(&perf_kernel);
 		for (int i = 0; i < NUM_PAGES; i++)
 			uassert(nanvix_vmem_read(buffer1, blks[i], RMEM_BLOCK_SIZE) == RMEM_BLOCK_SIZE);
-	perf_stop(0);
-	time_kernel = perf_read(0);
+	benchmark_perf_stop(&perf_kernel);
 
 #ifndef NDEBUG
 	uprintf("[benchmarks][memread] freeing memory...");
 #endif
-	perf_start(0, PERF_CYCLES);
+	benchmark_perf_start(&perf_free);
 		for (int i = NUM_PAGES - 1; i >= 0; i--)
 			uassert(nanvix_vmem_free(blks[i]) == 0);
-	perf_stop(0);
-	time_free = perf_read(0);
+	benchmark_perf_stop(&perf_free);
 
-#ifndef NDEBUG
-	uprintf("[benchmarks][memread] alloc %l read %l free %l",
-#else
-	uprintf("[benchmarks][memread] %l %l %l",
-#endif
-		time_alloc,
-		time_kernel,
-		time_free
-	);
+	benchmark_perf_record("memread", "blocks", 0, "alloc", &perf_alloc, 0);
+	benchmark_perf_record("memread", "blocks", 0, "read", &perf_kernel, NUM_PAGES*RMEM_BLOCK_SIZE);
+	benchmark_perf_record("memread", "blocks", 0, "free", &perf_free, 0);
 }
 
 /*============================================================================*
@@ -104,6 +98,8 @@ int __main3(int argc, const char *argv[])
 	((void) argc);
 	((void) argv);
 
+	benchmark_calibrate();
+
 	benchmark_memread();
 
 	return (0);
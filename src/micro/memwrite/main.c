@@ -25,6 +25,9 @@
 #include <nanvix/runtime/runtime.h>
 #include <nanvix/sys/perf.h>
 #include <nanvix/ulib.h>
+#include <benchmark/record.h>
+#include <benchmark/perf.h>
+#include <benchmark/calibration.h>
 
 /*============================================================================*
  * Benchmark                                                                  *
@@ -46,17 +49,16 @@ static char buffer1[RMEM_BLOCK_SIZE];
 static void benchmark_memwrite(void)
 {
 	void *blks[NUM_PAGES];
-	uint64_t time_alloc, time_kernel, time_free;
+	struct benchmark_perf perf_alloc, perf_kernel, perf_free;
 
 	/* Allocate memory .*/
 #ifndef NDEBUG
 	uprintf("[benchmarks][memwrite] allocating memory...");
 #endif
-	perf_start(0, PERF_CYCLES);
+	benchmark_perf_start(&perf_alloc);
 		for (int i = 0; i < NUM_PAGES; i++)
 			uassert((blks[i] = nanvix_vmem_alloc(1)) != NULL);
-	perf_stop(0);
-	time_alloc = perf_read(0);
+	benchmark_perf_stop(&perf_alloc);
 
 	umemset(buffer1, 1, RMEM_BLOCK_SIZE);
 
@@ -67,30 +69,22 @@ static void benchmark_memwrite(void)
 #ifndef NDEBUG
 	uprintf("[benchmarks][memwrite] benchmarking...");
 #endif
-	perf_start(0, PERF_CYCLES);
+	benchmark_perf_start(&perf_kernel);
 		for (int i = 0; i < NUM_PAGES; i++)
 			uassert(nanvix_vmem_write(blks[i], buffer1, RMEM_BLOCK_SIZE) == RMEM_BLOCK_SIZE);
-	perf_stop(0);
-	time_kernel = perf_read(0);
+	benchmark_perf_stop(&perf_kernel);
 
 #ifndef NDEBUG
 	uprintf("[benchmarks][memwrite] freeing memory...");
 #endif
-	perf_start(0, PERF_CYCLES);
+	benchmark_perf_start(&perf_free);
 		for (int i = NUM_PAGES - 1; i >= 0; i--)
 			uassert(nanvix_vmem_free(blks[i]) == 0);
-	perf_stop(0);
-	time_free = perf_read(0);
+	benchmark_perf_stop(&perf_free);
 
-#ifndef NDEBUG
-	uprintf("[benchmarks][memwrite] alloc %l write %l free %l",
-#else
-	uprintf("[benchmarks][memwrite] %l %l %l",
-#endif
-		time_alloc,
-		time_kernel,
-		time_free
-	);
+	benchmark_perf_record("memwrite", "blocks", 0, "alloc", &perf_alloc, 0);
+	benchmark_perf_record("memwrite", "blocks", 0, "write", &perf_kernel, NUM_PAGES*RMEM_BLOCK_SIZE);
+	benchmark_perf_record("memwrite", "blocks", 0, "free", &perf_free, 0);
 }
 
 /*============================================================================*
@@ -105,6 +99,8 @@ int __main3(int argc, const char *argv[])
 	((void) argc);
 	((void) argv);
 
+	benchmark_calibrate();
+
 	benchmark_memwrite();
 
 	return (0);
@@ -26,6 +26,10 @@
 #include <nanvix/sys/perf.h>
 #include <nanvix/limits.h>
 #include <nanvix/ulib.h>
+#include <benchmark/record.h>
+#include <benchmark/units.h>
+#include <benchmark/calibration.h>
+#include <benchmark/trace.h>
 
 /**
  * @brief Number of iterations for the benchmark.
@@ -108,10 +112,17 @@ static void do_leader(void)
 	/* Broadcast data. */
 	for (int k = 1; k <= NITERATIONS; k++)
 	{
+		benchmark_trace_begin(BENCHMARK_TRACE_BARRIER, -1, 0);
 		uassert(ksync_wait(syncin) == 0);
 		uassert(ksync_signal(syncout) == 0);
+		benchmark_trace_end(BENCHMARK_TRACE_BARRIER, -1, 0);
+
+		if (k == 1)
+			benchmark_trace_sync();
 	}
 
+	benchmark_trace_dump("signal", "barrier");
+
 	/* House keeping. */
 	uassert(ksync_close(syncout) == 0);
 	uassert(ksync_unlink(syncin) == 0);
@@ -153,25 +164,27 @@ static void do_worker(void)
 
 	for (int i = 1; i <= NITERATIONS; i++)
 	{
+		benchmark_trace_begin(BENCHMARK_TRACE_BARRIER, -1, 0);
 		uassert(ksync_signal(syncout) == 0);
 		uassert(ksync_wait(syncin) == 0);
+		benchmark_trace_end(BENCHMARK_TRACE_BARRIER, -1, 0);
+
+		if (i == 1)
+			benchmark_trace_sync();
 
 		uassert(ksync_ioctl(syncin, KSYNC_IOCTL_GET_LATENCY, &lin1) == 0);
 		uassert(ksync_ioctl(syncout, KSYNC_IOCTL_GET_LATENCY, &lout1) == 0);
 
 		/* Dump statistics. */
-#ifndef NDEBUG
-		uprintf("[benchmarks][signal][barrier] it=%d latency_in=%l latency_out=%l nsignals=%d, nwaits=%d",
-#else
-		uprintf("signal;barrier;%d;%l;%d,%d;",
-#endif
-			i, (lin1 - lin0), (lout1 - lout0), i, i
-		);
+		benchmark_record_time("signal", "barrier", i, "latency_in", (lin1 - lin0));
+		benchmark_record_time("signal", "barrier", i, "latency_out", (lout1 - lout0));
 
 		lin0  = lin1;
 		lout0 = lout1;
 	}
 
+	benchmark_trace_dump("signal", "barrier");
+
 	/* House keeping. */
 	uassert(ksync_close(syncout) == 0);
 	uassert(ksync_unlink(syncin) == 0);
@@ -202,6 +215,8 @@ int __main3(int argc, const char *argv[])
 	((void) argc);
 	((void) argv);
 
+	benchmark_calibrate();
+
 	benchmark_signal_barrier();
 
 	return (0);
@@ -26,6 +26,10 @@
 #include <nanvix/sys/perf.h>
 #include <nanvix/limits.h>
 #include <nanvix/ulib.h>
+#include <benchmark/record.h>
+#include <benchmark/units.h>
+#include <benchmark/calibration.h>
+#include <benchmark/trace.h>
 
 /**
  * @brief Number of iterations for the benchmark.
@@ -99,7 +103,13 @@ static void do_leader(void)
 
 	/* Broadcast data. */
 	for (int k = 1; k <= NITERATIONS; k++)
+	{
+		benchmark_trace_begin(BENCHMARK_TRACE_WAIT, -1, 0);
 		uassert(ksync_wait(syncin) == 0);
+		benchmark_trace_end(BENCHMARK_TRACE_WAIT, -1, 0);
+	}
+
+	benchmark_trace_dump("signal", "gather");
 
 	/* House keeping. */
 	uassert(ksync_unlink(syncin) == 0);
@@ -131,22 +141,20 @@ static void do_worker(void)
 
 	for (int i = 1; i <= NITERATIONS; i++)
 	{
+		benchmark_trace_begin(BENCHMARK_TRACE_SIGNAL, PROCESSOR_NODENUM_LEADER, 0);
 		uassert(ksync_signal(syncout) == 0);
+		benchmark_trace_end(BENCHMARK_TRACE_SIGNAL, PROCESSOR_NODENUM_LEADER, 0);
 
 		uassert(ksync_ioctl(syncout, KSYNC_IOCTL_GET_LATENCY, &l1) == 0);
 
 		/* Dump statistics. */
-#ifndef NDEBUG
-		uprintf("[benchmarks][signal][gather] it=%d latency=%l nsignals=%d",
-#else
-		uprintf("signal;gather;%d;%l;%d;",
-#endif
-			i, (l1 - l0), i
-		);
+		benchmark_record_time("signal", "gather", i, "latency", (l1 - l0));
 
 		l0 = l1;
 	}
 
+	benchmark_trace_dump("signal", "gather");
+
 	/* House keeping. */
 	uassert(ksync_close(syncout) == 0);
 }
@@ -176,6 +184,8 @@ int __main3(int argc, const char *argv[])
 	((void) argc);
 	((void) argv);
 
+	benchmark_calibrate();
+
 	benchmark_signal_gather();
 
 	return (0);
@@ -0,0 +1,189 @@
+/*
+ * MIT License
+ *
+ * Copyright(c) 2011-2020 The Maintainers of Nanvix
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <nanvix/runtime/runtime.h>
+#include <nanvix/sys/perf.h>
+#include <nanvix/ulib.h>
+#include <benchmark/record.h>
+#include <benchmark/units.h>
+#include <benchmark/stats.h>
+#include <benchmark/threads.h>
+#include <benchmark/calibration.h>
+
+/**
+ * @brief Number of iterations for the benchmark.
+ */
+#ifdef NDEBUG
+#define NITERATIONS 30
+#else
+#define NITERATIONS 1
+#endif
+
+/**
+ * @brief Threads.
+ */
+static kthread_t tids[BENCHMARK_THREADS_MAX];
+
+/**
+ * @brief Create and join latencies.
+ */
+/**@{*/
+static uint64_t creates[NITERATIONS];
+static uint64_t joins[NITERATIONS];
+/**@}*/
+
+/*============================================================================*
+ * Benchmark                                                                  *
+ *============================================================================*/
+
+/**
+ * @brief Trivial task.
+ */
+static void *task(void *arg)
+{
+	return (arg);
+}
+
+/**
+ * @brief Joins threads and checks their return values.
+ */
+static void threads_join(int nthreads)
+{
+	void *ret;
+
+	for (int i = 0; i < nthreads; i++)
+	{
+		uassert(kthread_join(tids[i], &ret) == 0);
+		uassert(ret == &tids[i]);
+	}
+}
+
+/**
+ * @brief Benchmarks the latency of creating and joining one thread.
+ */
+static void benchmark_thread_latency(void)
+{
+	uint64_t t0, t1;
+	void *ret;
+
+	for (int i = 0; i < NITERATIONS; i++)
+	{
+		kclock(&t0);
+			uassert(kthread_create(&tids[0], task, &tids[0]) == 0);
+		kclock(&t1);
+		creates[i] = benchmark_elapsed(t0, t1);
+
+		kclock(&t0);
+			uassert(kthread_join(tids[0], &ret) == 0);
+		kclock(&t1);
+		joins[i] = benchmark_elapsed(t0, t1);
+
+		uassert(ret == &tids[0]);
+
+		benchmark_record_time("thread", "single", i + 1, "create", creates[i]);
+		benchmark_record_time("thread", "single", i + 1, "join", joins[i]);
+	}
+
+	stats_sort(creates, NITERATIONS);
+	stats_sort(joins, NITERATIONS);
+	benchmark_record_time("thread", "single", 0, "create.p50", stats_percentile(creates, NITERATIONS, 50));
+	benchmark_record_time("thread", "single", 0, "create.p99", stats_percentile(creates, NITERATIONS, 99));
+	benchmark_record_time("thread", "single", 0, "join.p50", stats_percentile(joins, NITERATIONS, 50));
+	benchmark_record_time("thread", "single", 0, "join.p99", stats_percentile(joins, NITERATIONS, 99));
+}
+
+/**
+ * @brief Benchmarks creation throughput and fork-join time.
+ *
+ * @param nthreads Number of threads.
+ */
+static void benchmark_thread_forkjoin(int nthreads)
+{
+	uint64_t t0, t1, t2;
+	uint64_t create, forkjoin;
+	char variant[BENCHMARK_VARIANT_MAX];
+
+	usprintf(variant, "forkjoin:threads=%d", nthreads);
+
+	for (int i = 1; i <= NITERATIONS; i++)
+	{
+		kclock(&t0);
+
+			for (int j = 0; j < nthreads; j++)
+				uassert(kthread_create(&tids[j], task, &tids[j]) == 0);
+
+		kclock(&t1);
+
+			threads_join(nthreads);
+
+		kclock(&t2);
+
+		create = benchmark_elapsed(t0, t1);
+		forkjoin = benchmark_elapsed(t0, t2);
+
+		benchmark_record_time("thread", variant, i, "create", create);
+		benchmark_record_time("thread", variant, i, "forkjoin", forkjoin);
+		if (create > 0)
+		{
+			benchmark_record("thread", variant, i, "create.throughput",
+				((uint64_t) nthreads*BENCHMARK_TIMER_FREQ)/create,
+				BENCHMARK_UNIT_OPS
+			);
+		}
+	}
+}
+
+/**
+ * @brief Benchmarks the thread lifecycle.
+ */
+static void benchmark_thread(void)
+{
+	/* Warmup. */
+	uassert(kthread_create(&tids[0], task, &tids[0]) == 0);
+	threads_join(1);
+
+	benchmark_thread_latency();
+
+	for (int nthreads = 1; nthreads <= BENCHMARK_THREADS_MAX; nthreads++)
+		benchmark_thread_forkjoin(nthreads);
+}
+
+/*============================================================================*
+ * Benchmark Driver                                                           *
+ *============================================================================*/
+
+/**
+ * @brief Launches a benchmark.
+ */
+int __main3(int argc, const char *argv[])
+{
+	((void) argc);
+	((void) argv);
+
+	benchmark_calibrate();
+
+	benchmark_thread();
+
+	return (0);
+}
@@ -0,0 +1,535 @@
+/*
+ * MIT License
+ *
+ * Copyright(c) 2011-2020 The Maintainers of Nanvix
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <nanvix/runtime/runtime.h>
+#include <nanvix/sys/perf.h>
+#include <nanvix/ulib.h>
+#include <benchmark/record.h>
+#include <benchmark/units.h>
+#include <benchmark/stats.h>
+#include <benchmark/threads.h>
+#include <benchmark/calibration.h>
+
+/**
+ * @brief Number of iterations for the benchmark.
+ */
+#ifdef NDEBUG
+#define NITERATIONS 30
+#else
+#define NITERATIONS 1
+#endif
+
+/**
+ * @brief Lock operations per thread.
+ */
+#ifndef NOPS
+#define NOPS 1024
+#endif
+
+/**
+ * @brief Rounds of ping-pong and wakeup.
+ */
+#ifndef NROUNDS
+#define NROUNDS 256
+#endif
+
+/*============================================================================*
+ * Locks                                                                      *
+ *============================================================================*/
+
+/**
+ * @name Types of locks.
+ */
+/**@{*/
+#define LOCK_MUTEX     0 /**< Kernel mutex.            */
+#define LOCK_SEMAPHORE 1 /**< Kernel binary semaphore. */
+#define LOCK_SPINLOCK  2 /**< User-space spinlock.     */
+#define LOCK_TICKET    3 /**< User-space ticket lock.  */
+#define LOCK_NUM       4 /**< Number of locks.         */
+/**@}*/
+
+/**
+ * @brief Names of locks.
+ */
+static const char *locknames[LOCK_NUM] = {
+	"mutex", "semaphore", "spinlock", "ticket"
+};
+
+/**
+ * @brief Ticket lock.
+ *
+ * L1 data caches are not coherent on every target (e.g. k1b), so
+ * tickets are handed out under a HAL spinlock, and the served ticket
+ * is polled with the data cache invalidated.
+ */
+struct ticketlock
+{
+	spinlock_t lock;           /**< Guards ticket updates.   */
+	uint32_t next;             /**< Next ticket to hand out. */
+	volatile uint32_t serving; /**< Ticket being served.     */
+};
+
+/**
+ * @brief Locks.
+ */
+static struct
+{
+	int type;                      /**< Type of lock in use. */
+	struct nanvix_mutex mutex;     /**< Kernel mutex.        */
+	struct nanvix_semaphore sem;   /**< Binary semaphore.    */
+	spinlock_t spinlock;           /**< Spinlock.            */
+	struct ticketlock ticket;      /**< Ticket lock.         */
+} lock;
+
+/**
+ * @brief Acquires a ticket lock.
+ */
+static void ticketlock_lock(struct ticketlock *t)
+{
+	uint32_t ticket;
+
+	spinlock_lock(&t->lock);
+		ticket = t->next++;
+	spinlock_unlock(&t->lock);
+
+	do
+		dcache_invalidate();
+	while (t->serving != ticket);
+}
+
+/**
+ * @brief Releases a ticket lock.
+ */
+static void ticketlock_unlock(struct ticketlock *t)
+{
+	spinlock_lock(&t->lock);
+		t->serving++;
+	spinlock_unlock(&t->lock);
+}
+
+/**
+ * @brief Initializes all locks.
+ */
+static void lock_init(int type)
+{
+	lock.type = type;
+	uassert(nanvix_mutex_init(&lock.mutex, NULL) == 0);
+	uassert(nanvix_semaphore_init(&lock.sem, 1) == 0);
+	spinlock_init(&lock.spinlock);
+	spinlock_init(&lock.ticket.lock);
+	lock.ticket.next = 0;
+	lock.ticket.serving = 0;
+}
+
+/**
+ * @brief Destroys all locks.
+ */
+static void lock_destroy(void)
+{
+	uassert(nanvix_semaphore_destroy(&lock.sem) == 0);
+	uassert(nanvix_mutex_destroy(&lock.mutex) == 0);
+}
+
+/**
+ * @brief Acquires the lock in use.
+ */
+static void lock_acquire(void)
+{
+	switch (lock.type)
+	{
+		case LOCK_MUTEX:
+			uassert(nanvix_mutex_lock(&lock.mutex) == 0);
+			break;
+		case LOCK_SEMAPHORE:
+			uassert(nanvix_semaphore_down(&lock.sem) == 0);
+			break;
+		case LOCK_SPINLOCK:
+			spinlock_lock(&lock.spinlock);
+			break;
+		case LOCK_TICKET:
+			ticketlock_lock(&lock.ticket);
+			break;
+		default:
+			uassert(0);
+	}
+}
+
+/**
+ * @brief Releases the lock in use.
+ */
+static void lock_release(void)
+{
+	switch (lock.type)
+	{
+		case LOCK_MUTEX:
+			uassert(nanvix_mutex_unlock(&lock.mutex) == 0);
+			break;
+		case LOCK_SEMAPHORE:
+			uassert(nanvix_semaphore_up(&lock.sem) == 0);
+			break;
+		case LOCK_SPINLOCK:
+			spinlock_unlock(&lock.spinlock);
+			break;
+		case LOCK_TICKET:
+			ticketlock_unlock(&lock.ticket);
+			break;
+		default:
+			uassert(0);
+	}
+}
+
+/*============================================================================*
+ * Benchmark                                                                  *
+ *============================================================================*/
+
+/**
+ * @brief Threads.
+ */
+static kthread_t tids[BENCHMARK_THREADS_MAX];
+
+/**
+ * @brief Start gate of workers.
+ */
+static volatile int start;
+
+/**
+ * @brief Shared counter.
+ */
+static volatile uint64_t counter;
+
+/**
+ * @brief Acquire latencies of each thread.
+ */
+static uint64_t acquires[BENCHMARK_THREADS_MAX][NOPS];
+
+/**
+ * @brief Wakeup latencies.
+ */
+static uint64_t latencies[NROUNDS];
+
+/**
+ * @brief Semaphores for ping-pong.
+ */
+/**@{*/
+static struct nanvix_semaphore ping;
+static struct nanvix_semaphore pong;
+/**@}*/
+
+/**
+ * @brief Condition variable wakeup.
+ */
+static struct
+{
+	struct nanvix_mutex mutex;   /**< Mutex.                        */
+	struct nanvix_cond_var cond; /**< Condition variable.           */
+	int waiting;                 /**< Waiter is blocked?            */
+	int flag;                    /**< Condition.                    */
+	uint64_t signaled;           /**< Clock value at signal.        */
+	uint64_t woken;              /**< Clock value at wakeup.        */
+	struct nanvix_semaphore ack; /**< Waiter is done with a round.  */
+} wakeup;
+
+/**
+ * @brief Benchmarks uncontended acquire/release latency.
+ */
+static void benchmark_threadsync_latency(void)
+{
+	uint64_t t0, t1;
+	char variant[BENCHMARK_VARIANT_MAX];
+
+	for (int type = 0; type < LOCK_NUM; type++)
+	{
+		lock_init(type);
+
+		usprintf(variant, "latency:lock=%s", locknames[type]);
+
+		for (int i = 1; i <= NITERATIONS; i++)
+		{
+			kclock(&t0);
+
+				for (int j = 0; j < NOPS; j++)
+				{
+					lock_acquire();
+					lock_release();
+				}
+
+			kclock(&t1);
+
+			benchmark_record_time("threadsync", variant, i, "pair", benchmark_elapsed(t0, t1)/NOPS);
+		}
+
+		lock_destroy();
+	}
+}
+
+/**
+ * @brief Increments the shared counter.
+ *
+ * @param arg Slot of the thread in acquires[].
+ */
+static void *counter_worker(void *arg)
+{
+	uint64_t t0, t1;
+	uint64_t *samples = arg;
+
+	do
+		dcache_invalidate();
+	while (!start);
+
+	for (int i = 0; i < NOPS; i++)
+	{
+		kclock(&t0);
+		lock_acquire();
+		kclock(&t1);
+			counter++;
+		lock_release();
+
+		samples[i] = benchmark_elapsed(t0, t1);
+	}
+
+	return (arg);
+}
+
+/**
+ * @brief Benchmarks a contended counter.
+ *
+ * @param type     Type of lock.
+ * @param nthreads Number of threads.
+ */
+static void benchmark_threadsync_counter(int type, int nthreads)
+{
+	uint64_t t0, t1, elapsed;
+	char variant[BENCHMARK_VARIANT_MAX];
+	char metric[BENCHMARK_VARIANT_MAX];
+
+	usprintf(variant, "counter:lock=%s,threads=%d", locknames[type], nthreads);
+
+	lock_init(type);
+
+	for (int i = 1; i <= NITERATIONS; i++)
+	{
+		counter = 0;
+		start = 0;
+		dcache_invalidate();
+
+		for (int j = 0; j < nthreads; j++)
+			uassert(kthread_create(&tids[j], counter_worker, acquires[j]) == 0);
+
+		kclock(&t0);
+
+			start = 1;
+			dcache_invalidate();
+
+			for (int j = 0; j < nthreads; j++)
+				uassert(kthread_join(tids[j], NULL) == 0);
+
+		kclock(&t1);
+		elapsed = benchmark_elapsed(t0, t1);
+
+		dcache_invalidate();
+		uassert(counter == (uint64_t) nthreads*NOPS);
+
+		benchmark_record_time("threadsync", variant, i, "time", elapsed);
+		if (elapsed > 0)
+		{
+			benchmark_record("threadsync", variant, i, "throughput",
+				((uint64_t) nthreads*NOPS*BENCHMARK_TIMER_FREQ)/elapsed,
+				BENCHMARK_UNIT_OPS
+			);
+		}
+
+		/* One metric per thread, so unfair locks show up as spread. */
+		for (int j = 0; j < nthreads; j++)
+		{
+			usprintf(metric, "acquire.p50.t%d", j);
+			stats_sort(acquires[j], NOPS);
+			benchmark_record_time("threadsync", variant, i, metric, stats_percentile(acquires[j], NOPS, 50));
+		}
+	}
+
+	lock_destroy();
+}
+
+/**
+ * @brief Answers pings.
+ */
+static void *pingpong_worker(void *arg)
+{
+	for (int i = 0; i < NROUNDS; i++)
+	{
+		uassert(nanvix_semaphore_down(&ping) == 0);
+		uassert(nanvix_semaphore_up(&pong) == 0);
+	}
+
+	return (arg);
+}
+
+/**
+ * @brief Benchmarks semaphore ping-pong between two threads.
+ */
+static void benchmark_threadsync_pingpong(void)
+{
+	uint64_t t0, t1;
+
+	uassert(nanvix_semaphore_init(&ping, 0) == 0);
+	uassert(nanvix_semaphore_init(&pong, 0) == 0);
+
+	for (int i = 1; i <= NITERATIONS; i++)
+	{
+		uassert(kthread_create(&tids[0], pingpong_worker, NULL) == 0);
+
+		kclock(&t0);
+
+			for (int j = 0; j < NROUNDS; j++)
+			{
+				uassert(nanvix_semaphore_up(&ping) == 0);
+				uassert(nanvix_semaphore_down(&pong) == 0);
+			}
+
+		kclock(&t1);
+
+		uassert(kthread_join(tids[0], NULL) == 0);
+
+		benchmark_record_time("threadsync", "pingpong:semaphore", i, "roundtrip", benchmark_elapsed(t0, t1)/NROUNDS);
+	}
+
+	uassert(nanvix_semaphore_destroy(&pong) == 0);
+	uassert(nanvix_semaphore_destroy(&ping) == 0);
+}
+
+/**
+ * @brief Waits on the condition variable.
+ */
+static void *wakeup_worker(void *arg)
+{
+	for (int i = 0; i < NROUNDS; i++)
+	{
+		uassert(nanvix_mutex_lock(&wakeup.mutex) == 0);
+
+			wakeup.waiting = 1;
+			while (!wakeup.flag)
+				uassert(nanvix_cond_wait(&wakeup.cond, &wakeup.mutex) == 0);
+			kclock(&wakeup.woken);
+
+			wakeup.flag = 0;
+			wakeup.waiting = 0;
+
+		uassert(nanvix_mutex_unlock(&wakeup.mutex) == 0);
+
+		uassert(nanvix_semaphore_up(&wakeup.ack) == 0);
+	}
+
+	return (arg);
+}
+
+/**
+ * @brief Benchmarks condition variable wakeup latency.
+ *
+ * The signal is sent only once the waiter is known to be blocked, so
+ * that each round measures an actual wakeup.
+ */
+static void benchmark_threadsync_wakeup(void)
+{
+	int waiting;
+
+	uassert(nanvix_mutex_init(&wakeup.mutex, NULL) == 0);
+	uassert(nanvix_cond_init(&wakeup.cond) == 0);
+	uassert(nanvix_semaphore_init(&wakeup.ack, 0) == 0);
+
+	for (int i = 1; i <= NITERATIONS; i++)
+	{
+		wakeup.waiting = 0;
+		wakeup.flag = 0;
+
+		uassert(kthread_create(&tids[0], wakeup_worker, NULL) == 0);
+
+		for (int j = 0; j < NROUNDS; j++)
+		{
+			do
+			{
+				uassert(nanvix_mutex_lock(&wakeup.mutex) == 0);
+
+				if ((waiting = wakeup.waiting))
+				{
+					wakeup.flag = 1;
+					kclock(&wakeup.signaled);
+					uassert(nanvix_cond_signal(&wakeup.cond) == 0);
+				}
+
+				uassert(nanvix_mutex_unlock(&wakeup.mutex) == 0);
+			} while (!waiting);
+
+			uassert(nanvix_semaphore_down(&wakeup.ack) == 0);
+
+			latencies[j] = benchmark_elapsed(wakeup.signaled, wakeup.woken);
+		}
+
+		uassert(kthread_join(tids[0], NULL) == 0);
+
+		stats_sort(latencies, NROUNDS);
+		benchmark_record_time("threadsync", "wakeup:condvar", i, "p50", stats_percentile(latencies, NROUNDS, 50));
+		benchmark_record_time("threadsync", "wakeup:condvar", i, "p99", stats_percentile(latencies, NROUNDS, 99));
+		benchmark_record_time("threadsync", "wakeup:condvar", i, "max", latencies[NROUNDS - 1]);
+	}
+
+	uassert(nanvix_semaphore_destroy(&wakeup.ack) == 0);
+	uassert(nanvix_cond_destroy(&wakeup.cond) == 0);
+	uassert(nanvix_mutex_destroy(&wakeup.mutex) == 0);
+}
+
+/**
+ * @brief Benchmarks intra-cluster synchronization.
+ */
+static void benchmark_threadsync(void)
+{
+	benchmark_threadsync_latency();
+
+	for (int type = 0; type < LOCK_NUM; type++)
+	{
+		for (int nthreads = 1; nthreads <= BENCHMARK_THREADS_MAX; nthreads++)
+			benchmark_threadsync_counter(type, nthreads);
+	}
+
+	benchmark_threadsync_pingpong();
+	benchmark_threadsync_wakeup();
+}
+
+/*============================================================================*
+ * Benchmark Driver                                                           *
+ *============================================================================*/
+
+/**
+ * @brief Launches a benchmark.
+ */
+int __main3(int argc, const char *argv[])
+{
+	((void) argc);
+	((void) argv);
+
+	benchmark_calibrate();
+
+	benchmark_threadsync();
+
+	return (0);
+}
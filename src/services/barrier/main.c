@@ -26,6 +26,9 @@
 #include <nanvix/runtime/runtime.h>
 #include <nanvix/sys/perf.h>
 #include <nanvix/ulib.h>
+#include <benchmark/record.h>
+#include <benchmark/perf.h>
+#include <benchmark/calibration.h>
 
 /*============================================================================*
  * Barrier                                                                    *
@@ -178,24 +181,17 @@ void slow_barrier_wait(void)
  */
 static void benchmark_slow_barrier(void)
 {
-	uint64_t time_slow_barrier;
+	struct benchmark_perf perf_slow_barrier;
 
 	slow_barrier_setup();
 
-	perf_start(0, PERF_CYCLES);
+	benchmark_perf_start(&perf_slow_barrier);
 	slow_barrier_wait();
-	perf_stop(0);
-	time_slow_barrier = perf_read(0);
+	benchmark_perf_stop(&perf_slow_barrier);
 
 	slow_barrier_cleanup();
 
-#ifndef NDEBUG
-	uprintf("[benchmarks][slow_barrier] %l",
-#else
-	uprintf("[benchmarks][slow_barrier] %l",
-#endif
-		time_slow_barrier
-	);
+	benchmark_perf_record("barrier", "slow", 0, "time", &perf_slow_barrier, 0);
 }
 
 /*============================================================================*
@@ -210,6 +206,8 @@ int __main3(int argc, const char *argv[])
 	((void) argc);
 	((void) argv);
 
+	benchmark_calibrate();
+
 	benchmark_slow_barrier();
 
 	return (0);
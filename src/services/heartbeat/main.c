@@ -25,6 +25,9 @@
 #include <nanvix/runtime/runtime.h>
 #include <nanvix/sys/perf.h>
 #include <nanvix/ulib.h>
+#include <benchmark/record.h>
+#include <benchmark/perf.h>
+#include <benchmark/calibration.h>
 
 /*============================================================================*
  * Benchmark                                                                  *
@@ -35,20 +38,13 @@
  */
 static void benchmark_heartbeat(void)
 {
-	uint64_t time_heartbeat;
+	struct benchmark_perf perf_heartbeat;
 
-	perf_start(0, PERF_CYCLES);
+	benchmark_perf_start(&perf_heartbeat);
 	name_heartbeat();
-	perf_stop(0);
-	time_heartbeat = perf_read(0);
+	benchmark_perf_stop(&perf_heartbeat);
 
-#ifndef NDEBUG
-	uprintf("[benchmarks][heartbeat] %l",
-#else
-	uprintf("[benchmarks][heartbeat] %l",
-#endif
-		time_heartbeat
-	);
+	benchmark_perf_record("heartbeat", "single", 0, "time", &perf_heartbeat, 0);
 }
 
 /*============================================================================*
@@ -63,6 +59,8 @@ int __main3(int argc, const char *argv[])
 	((void) argc);
 	((void) argv);
 
+	benchmark_calibrate();
+
 	benchmark_heartbeat();
 
 	return (0);
@@ -26,35 +26,206 @@
 #include <nanvix/sys/perf.h>
 #include <nanvix/ulib.h>
 #include <nanvix/pm.h>
+#include <benchmark/namecache.h>
+#include <benchmark/record.h>
+#include <benchmark/units.h>
+#include <benchmark/perf.h>
+#include <benchmark/stats.h>
+#include <benchmark/calibration.h>
+
+/**
+ * @brief Number of lookups in each run.
+ */
+#ifdef NDEBUG
+#define NLOOKUPS 100
+#else
+#define NLOOKUPS 10
+#endif
+
+/**
+ * @brief Number of lookups in the staleness run.
+ */
+#ifndef NSTALE
+#define NSTALE (4*NLOOKUPS)
+#endif
+
+/**
+ * @brief Number of lookups between two changes of a binding in the
+ * staleness run.
+ */
+#ifndef STALE_PERIOD
+#define STALE_PERIOD 8
+#endif
+
+/**
+ * @brief Number of lookups between two heartbeats in the staleness run.
+ */
+#ifndef STALE_HEARTBEAT
+#define STALE_HEARTBEAT 4
+#endif
+
+/**
+ * @brief Delay between two lookups in the staleness run (in cycles).
+ */
+#ifndef STALE_DELAY
+#define STALE_DELAY (NAME_CACHE_TTL/4)
+#endif
 
 /*============================================================================*
- * Benchmark                                                                  *
+ * Benchmark Kernel                                                           *
  *============================================================================*/
 
 /**
- * @brief Benchmarks name lookups.
+ * @brief Lookup latencies.
+ */
+static uint64_t latencies[NLOOKUPS];
+
+/**
+ * @brief Forces a platform-independent delay.
+ *
+ * @param cycles Delay in cycles.
+ */
+static void delay(uint64_t cycles)
+{
+	uint64_t t0, t1;
+
+	kclock(&t0);
+
+	do
+		kclock(&t1);
+	while ((t1 - t0) < cycles);
+}
+
+/**
+ * @brief Dumps percentiles of lookup latencies.
+ *
+ * @param mode Lookup mode.
+ */
+static void dump_latencies(const char *mode)
+{
+	stats_sort(latencies, NLOOKUPS);
+
+	benchmark_record_time("lookup", mode, 0, "p50", stats_percentile(latencies, NLOOKUPS, 50));
+	benchmark_record_time("lookup", mode, 0, "p90", stats_percentile(latencies, NLOOKUPS, 90));
+	benchmark_record_time("lookup", mode, 0, "p99", stats_percentile(latencies, NLOOKUPS, 99));
+}
+
+/**
+ * @brief Benchmarks uncached name lookups.
  */
 static void benchmark_lookup(void)
 {
 	int nodenum;
 	const char *pname;
-	uint64_t time_lookup;
+	struct benchmark_perf perf;
 
 	nodenum = knode_get_num();
 	pname = nanvix_getpname();
 
-	perf_start(0, PERF_CYCLES);
-	uassert(name_lookup(pname) == nodenum);
-	perf_stop(0);
-	time_lookup = perf_read(0);
+	for (int i = 0; i < NLOOKUPS; i++)
+	{
+		benchmark_perf_start(&perf);
+		uassert(name_lookup(pname) == nodenum);
+		benchmark_perf_stop(&perf);
+		latencies[i] = benchmark_perf_cycles(&perf);
+	}
 
-#ifndef NDEBUG
-	uprintf("[benchmarks][lookup] %l",
-#else
-	uprintf("[benchmarks][lookup] %l",
-#endif
-		time_lookup
-	);
+	dump_latencies("uncached");
+}
+
+/**
+ * @brief Benchmarks cached name lookups.
+ */
+static void benchmark_lookup_cached(void)
+{
+	int nodenum;
+	const char *pname;
+	struct benchmark_perf perf;
+
+	nodenum = knode_get_num();
+	pname = nanvix_getpname();
+
+	/* Misses. */
+	for (int i = 0; i < NLOOKUPS; i++)
+	{
+		name_cache_flush();
+
+		benchmark_perf_start(&perf);
+		uassert(name_cache_lookup(pname) == nodenum);
+		benchmark_perf_stop(&perf);
+		latencies[i] = benchmark_perf_cycles(&perf);
+	}
+
+	dump_latencies("miss");
+
+	/* Hits. */
+	uassert(name_cache_lookup(pname) == nodenum);
+	for (int i = 0; i < NLOOKUPS; i++)
+	{
+		benchmark_perf_start(&perf);
+		uassert(name_cache_lookup(pname) == nodenum);
+		benchmark_perf_stop(&perf);
+		latencies[i] = benchmark_perf_cycles(&perf);
+	}
+
+	dump_latencies("hit");
+}
+
+/**
+ * @brief Benchmarks staleness of cached name lookups.
+ *
+ * A binding is periodically removed and restored behind the back of the
+ * name cache, as another client would do, and cached lookups are checked
+ * against the name server. Heartbeats are sent periodically, so that
+ * staleness is bounded by both NAME_CACHE_TTL and NAME_CACHE_HEARTBEATS.
+ */
+static void benchmark_lookup_staleness(void)
+{
+	int nstale;
+	int linked;
+	int cached, actual;
+	const char *name = "lookup-stale";
+
+	name_cache_flush();
+	name_cache.hits = 0;
+	name_cache.misses = 0;
+
+	uassert(name_link(knode_get_num(), name) == 0);
+	linked = 1;
+
+	nstale = 0;
+	for (int i = 1; i <= NSTALE; i++)
+	{
+		/* Change binding, bypassing the cache. */
+		if ((i % STALE_PERIOD) == 0)
+		{
+			if (linked)
+				uassert(name_unlink(name) == 0);
+			else
+				uassert(name_link(knode_get_num(), name) == 0);
+			linked = !linked;
+		}
+
+		/* Age cache. */
+		if ((i % STALE_HEARTBEAT) == 0)
+			uassert(name_cache_heartbeat() == 0);
+
+		cached = name_cache_lookup(name);
+		actual = name_lookup(name);
+
+		if ((cached < 0) != (actual < 0))
+			nstale++;
+
+		delay(STALE_DELAY);
+	}
+
+	if (linked)
+		uassert(name_unlink(name) == 0);
+
+	benchmark_record("lookup", "stale", 0, "lookups", NSTALE, BENCHMARK_UNIT_COUNT);
+	benchmark_record("lookup", "stale", 0, "hits", name_cache.hits, BENCHMARK_UNIT_COUNT);
+	benchmark_record("lookup", "stale", 0, "misses", name_cache.misses, BENCHMARK_UNIT_COUNT);
+	benchmark_record("lookup", "stale", 0, "stale", nstale, BENCHMARK_UNIT_COUNT);
 }
 
 /*============================================================================*
@@ -69,7 +240,11 @@ int __main3(int argc, const char *argv[])
 	((void) argc);
 	((void) argv);
 
+	benchmark_calibrate();
+
 	benchmark_lookup();
+	benchmark_lookup_cached();
+	benchmark_lookup_staleness();
 
 	return (0);
 }
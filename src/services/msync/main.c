@@ -28,6 +28,137 @@
 #include <nanvix/ulib.h>
 #include <nanvix/limits.h>
 #include <posix/sys/stat.h>
+#include <benchmark/record.h>
+#include <benchmark/perf.h>
+#include <benchmark/calibration.h>
+
+/**
+ * @brief Number of iterations for the benchmark.
+ */
+#ifdef NDEBUG
+#define NITERATIONS 30
+#else
+#define NITERATIONS 1
+#endif
+
+/**
+ * @brief Number of region sizes in the sweep.
+ *
+ * Region sizes are multiples of (NANVIX_SHM_SIZE_MAX / MSYNC_REGION_STEPS).
+ */
+#ifndef MSYNC_REGION_STEPS
+#define MSYNC_REGION_STEPS 4
+#endif
+
+/**
+ * @brief Number of dirty fractions in the sweep.
+ *
+ * The dirty fraction goes from 0/MSYNC_DIRTY_STEPS up to
+ * MSYNC_DIRTY_STEPS/MSYNC_DIRTY_STEPS of the region.
+ */
+#ifndef MSYNC_DIRTY_STEPS
+#define MSYNC_DIRTY_STEPS 4
+#endif
+
+/*============================================================================*
+ * Cost Model                                                                 *
+ *============================================================================*/
+
+/**
+ * @brief Linear cost model.
+ *
+ * The cost of an operation is modeled as:
+ *
+ *   cost = base + per_dirty * dirty_kb + per_region * region_kb
+ *
+ * and the coefficients are fitted with ordinary least squares.
+ */
+struct cost_model
+{
+	double n;       /**< Number of samples.              */
+	double s[3];    /**< Sum of regressors (1, D, R).    */
+	double ss[3][3];/**< Sum of products of regressors.  */
+	double sy[3];   /**< Sum of regressors times costs.  */
+};
+
+/**
+ * @brief Adds a sample to a cost model.
+ *
+ * @param m      Target cost model.
+ * @param dirty  Dirty size (in bytes).
+ * @param region Region size (in bytes).
+ * @param cost   Observed cost (in cycles).
+ */
+static void cost_model_add(struct cost_model *m, size_t dirty, size_t region, uint64_t cost)
+{
+	double x[3];
+
+	x[0] = 1.0;
+	x[1] = ((double) dirty)/1024.0;
+	x[2] = ((double) region)/1024.0;
+
+	m->n += 1.0;
+	for (int i = 0; i < 3; i++)
+	{
+		m->s[i] += x[i];
+		m->sy[i] += x[i]*((double) cost);
+		for (int j = 0; j < 3; j++)
+			m->ss[i][j] += x[i]*x[j];
+	}
+}
+
+/**
+ * @brief Computes the determinant of a 3x3 matrix.
+ */
+static double det3(double a[3][3])
+{
+	return (
+		a[0][0]*(a[1][1]*a[2][2] - a[1][2]*a[2][1]) -
+		a[0][1]*(a[1][0]*a[2][2] - a[1][2]*a[2][0]) +
+		a[0][2]*(a[1][0]*a[2][1] - a[1][1]*a[2][0])
+	);
+}
+
+/**
+ * @brief Fits a cost model.
+ *
+ * @param m    Target cost model.
+ * @param coef Fitted coefficients (base, per dirty KB, per region KB).
+ *
+ * @returns Upon successful completion, zero is returned. Otherwise, the
+ * samples do not determine the model and a negative number is returned.
+ */
+static int cost_model_fit(const struct cost_model *m, double coef[3])
+{
+	double d;
+	double a[3][3];
+
+	for (int i = 0; i < 3; i++)
+	{
+		for (int j = 0; j < 3; j++)
+			a[i][j] = m->ss[i][j];
+	}
+
+	d = det3(a);
+
+	/* Singular system. */
+	if ((d < 1e-9) && (d > -1e-9))
+		return (-1);
+
+	/* Cramer's rule. */
+	for (int k = 0; k < 3; k++)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			for (int j = 0; j < 3; j++)
+				a[i][j] = (j == k) ? m->sy[i] : m->ss[i][j];
+		}
+
+		coef[k] = det3(a)/d;
+	}
+
+	return (0);
+}
 
 /*============================================================================*
  * Benchmark                                                                  *
@@ -36,44 +167,131 @@
 /**
  * @brief Dummy buffer used for tests.
  */
-static char buffer[RMEM_BLOCK_SIZE];
+static char buffer[NANVIX_SHM_SIZE_MAX];
+
+/**
+ * @brief Cost model for invalidations.
+ */
+static struct cost_model model_inval;
+
+/**
+ * @brief Cost model for re-fetches.
+ */
+static struct cost_model model_refetch;
+
+/**
+ * @brief Benchmarks invalidation of a shared memory region.
+ *
+ * @param shmid  ID of the target shared memory region.
+ * @param region Size of the region (in bytes).
+ * @param dirty  Number of bytes to dirty before invalidating the region.
+ */
+static void benchmark_msync_point(int shmid, size_t region, size_t dirty)
+{
+	char variant[BENCHMARK_VARIANT_MAX];
+	struct benchmark_perf perf_inval, perf_refetch;
+
+	usprintf(variant, "sweep:region=%d,dirty=%d", (int) region, (int) dirty);
+
+	for (int i = 1; i <= NITERATIONS; i++)
+	{
+		/* Bring the whole region in a clean state. */
+		uassert(__nanvix_shm_read(shmid, buffer, region, 0) == (ssize_t) region);
+
+		/* Dirty part of it. */
+		if (dirty > 0)
+		{
+			umemset(buffer, i & 0xff, dirty);
+			uassert(__nanvix_shm_write(shmid, buffer, dirty, 0) == (ssize_t) dirty);
+		}
+
+		benchmark_perf_start(&perf_inval);
+		uassert(__nanvix_shm_inval(shmid) == 0);
+		benchmark_perf_stop(&perf_inval);
+
+		benchmark_perf_start(&perf_refetch);
+		uassert(__nanvix_shm_read(shmid, buffer, region, 0) == (ssize_t) region);
+		benchmark_perf_stop(&perf_refetch);
+
+		cost_model_add(&model_inval, dirty, region, benchmark_perf_cycles(&perf_inval));
+		cost_model_add(&model_refetch, dirty, region, benchmark_perf_cycles(&perf_refetch));
+
+		benchmark_perf_record("msync", variant, i, "inval", &perf_inval, dirty);
+		benchmark_perf_record("msync", variant, i, "refetch", &perf_refetch, region);
+	}
+}
+
+/**
+ * @brief Rounds a coefficient to the nearest integer.
+ */
+static int64_t coef_round(double x)
+{
+	return ((int64_t) ((x < 0.0) ? (x - 0.5) : (x + 0.5)));
+}
+
+/**
+ * @brief Dumps a fitted cost model.
+ *
+ * Slopes are often below one cycle per KB, so they are reported per MB
+ * to keep three more digits in integer records.
+ *
+ * @param name Name of the cost model.
+ * @param m    Target cost model.
+ */
+static void benchmark_msync_model(const char *name, const struct cost_model *m)
+{
+	double coef[3];
+	char variant[BENCHMARK_VARIANT_MAX];
+
+	if (cost_model_fit(m, coef) < 0)
+	{
+		uprintf("[benchmarks][msync] %s model is undetermined", name);
+		return;
+	}
+
+	usprintf(variant, "model:op=%s", name);
+
+	benchmark_record_signed("msync", variant, 0, "base", coef_round(coef[0]), BENCHMARK_UNIT_CYCLES);
+	benchmark_record_signed("msync", variant, 0, "dirty", coef_round(coef[1]*1024.0), BENCHMARK_UNIT_CYCLESMB);
+	benchmark_record_signed("msync", variant, 0, "region", coef_round(coef[2]*1024.0), BENCHMARK_UNIT_CYCLESMB);
+}
 
 /**
  * @brief Benchmarks invalidation of shared memory regions.
+ *
+ * Region size and dirty fraction are swept independently, and both the
+ * invalidation and the re-fetch that follows it are timed. Costs are
+ * fitted to a linear model of dirty and region sizes.
  */
 static void benchmark_msync(void)
 {
 	int shmid;
+	size_t region;
 	const char *shm_name = "cool-region";
-	uint64_t time_msync;
 
 	/* Leader. */
 	if (kcluster_get_num() == PROCESSOR_CLUSTERNUM_LEADER)
 	{
-		uassert((shmid = __nanvix_shm_open(shm_name, O_RDWR | O_CREAT, S_IWUSR | S_IRUSR)) >= 0);
+		for (int i = 1; i <= MSYNC_REGION_STEPS; i++)
+		{
+			region = (NANVIX_SHM_SIZE_MAX/MSYNC_REGION_STEPS)*i;
 
-			uassert(__nanvix_shm_ftruncate(shmid, NANVIX_SHM_SIZE_MAX) == 0);
+			uassert((shmid = __nanvix_shm_open(shm_name, O_RDWR | O_CREAT, S_IWUSR | S_IRUSR)) >= 0);
+			uassert(__nanvix_shm_ftruncate(shmid, region) == 0);
 
-			umemset(buffer, 1, NANVIX_SHM_SIZE_MAX);
-			uassert(__nanvix_shm_write(shmid, buffer, NANVIX_SHM_SIZE_MAX, 0) == NANVIX_SHM_SIZE_MAX);
-			umemset(buffer, 0, NANVIX_SHM_SIZE_MAX);
-			uassert(__nanvix_shm_read(shmid, buffer, NANVIX_SHM_SIZE_MAX, 0) == NANVIX_SHM_SIZE_MAX);
+				/* Initialize region. */
+				umemset(buffer, 1, region);
+				uassert(__nanvix_shm_write(shmid, buffer, region, 0) == (ssize_t) region);
 
-			perf_start(0, PERF_CYCLES);
-			uassert(__nanvix_shm_inval(shmid) == 0);
-			perf_stop(0);
-			time_msync = perf_read(0);
+				for (int j = 0; j <= MSYNC_DIRTY_STEPS; j++)
+					benchmark_msync_point(shmid, region, (region/MSYNC_DIRTY_STEPS)*j);
 
-		uassert(__nanvix_shm_close(shmid) == 0);
-		uassert(__nanvix_shm_unlink(shm_name) == 0);
+			uassert(__nanvix_shm_close(shmid) == 0);
+			uassert(__nanvix_shm_unlink(shm_name) == 0);
+		}
 
-#ifndef NDEBUG
-		uprintf("[benchmarks][msync] %l",
-#else
-		uprintf("[benchmarks][msync] %l",
-#endif
-			time_msync
-		);
+		benchmark_msync_model("inval", &model_inval);
+		benchmark_msync_model("refetch", &model_refetch);
 	}
 }
 
@@ -92,6 +310,8 @@ int __main3(int argc, const char *argv[])
 	((void) argc);
 	((void) argv);
 
+	benchmark_calibrate();
+
 	/* Build list of nodes. */
 	for (int i = 0; i < NANVIX_PROC_MAX; i++)
 		nodes[i] = PROCESSOR_NODENUM_LEADER + i;
@@ -0,0 +1,319 @@
+/*
+ * MIT License
+ *
+ * Copyright(c) 2011-2020 The Maintainers of Nanvix
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <nanvix/runtime/runtime.h>
+#include <nanvix/runtime/barrier.h>
+#include <nanvix/sys/perf.h>
+#include <nanvix/limits.h>
+#include <nanvix/ulib.h>
+#include <benchmark/stats.h>
+#include <benchmark/record.h>
+#include <benchmark/units.h>
+#include <benchmark/perf.h>
+#include <benchmark/calibration.h>
+
+/**
+ * @brief Capacity of the name server table.
+ *
+ * Override it to match the name server in use.
+ */
+#ifndef NAME_TABLE_SIZE
+#define NAME_TABLE_SIZE 512
+#endif
+
+/**
+ * @brief Number of names registered by each node.
+ *
+ * By default, the table is filled up, leaving one slot per node for the
+ * name of the process itself.
+ */
+#ifndef NAMES_PER_NODE
+#ifdef NDEBUG
+#define NAMES_PER_NODE (NAME_TABLE_SIZE/NANVIX_PROC_MAX - 1)
+#else
+#define NAMES_PER_NODE 8
+#endif
+#endif
+
+#if (NANVIX_PROC_MAX*(NAMES_PER_NODE + 1)) > NAME_TABLE_SIZE
+#error "NAMES_PER_NODE exceeds the capacity of the name server table"
+#endif
+
+/**
+ * @brief Number of names registered by each node between two
+ * measurements of lookup latency.
+ */
+#ifndef BATCH_SIZE
+#define BATCH_SIZE ((NAMES_PER_NODE + 7)/8)
+#endif
+
+/**
+ * @brief Number of batches.
+ */
+#define NBATCHES ((NAMES_PER_NODE + BATCH_SIZE - 1)/BATCH_SIZE)
+
+/**
+ * @brief Number of lookups issued at each table occupancy.
+ */
+#ifndef NPROBES
+#define NPROBES 16
+#endif
+
+static barrier_t barrier;
+static int nodes[NANVIX_PROC_MAX];
+
+/*============================================================================*
+ * Benchmark Kernel                                                           *
+ *============================================================================*/
+
+/**
+ * @brief Latencies of name_link().
+ */
+static uint64_t link_latencies[NAMES_PER_NODE];
+
+/**
+ * @brief Latencies of name_unlink().
+ */
+static uint64_t unlink_latencies[NAMES_PER_NODE];
+
+/**
+ * @brief Latencies of name_lookup().
+ */
+static uint64_t lookup_latencies[NPROBES];
+
+/**
+ * @brief Mean lookup latency at each occupancy.
+ */
+static uint64_t lookup_means[NBATCHES];
+
+/**
+ * @brief Builds a name.
+ *
+ * @param name Store location for the name.
+ * @param idx  Index of the owner node.
+ * @param k    Index of the name in the owner node.
+ */
+static void build_name(char *name, int idx, int k)
+{
+	usprintf(name, "churn-%d-%d", idx, k);
+}
+
+/**
+ * @brief Dumps percentiles of latencies.
+ *
+ * @param op        Name of the operation.
+ * @param occupancy Number of names in the table.
+ * @param latencies Target latencies.
+ * @param n         Number of latencies.
+ */
+static void dump_latencies(const char *op, int occupancy, uint64_t *latencies, int n)
+{
+	char variant[BENCHMARK_VARIANT_MAX];
+
+	stats_sort(latencies, n);
+	usprintf(variant, "churn:op=%s,names=%d", op, occupancy);
+
+	benchmark_record_time("nameserver", variant, 0, "mean", stats_mean(latencies, n));
+	benchmark_record_time("nameserver", variant, 0, "p50", stats_percentile(latencies, n, 50));
+	benchmark_record_time("nameserver", variant, 0, "p99", stats_percentile(latencies, n, 99));
+}
+
+/**
+ * @brief Measures lookup latency at the current table occupancy.
+ *
+ * @param occupancy Number of names in the table.
+ * @param nlinked   Number of names registered by this node.
+ *
+ * @returns The mean lookup latency.
+ */
+static uint64_t probe_lookups(int occupancy, int nlinked)
+{
+	int me;
+	char name[NANVIX_PROC_NAME_MAX];
+	uint64_t mean;
+	struct benchmark_perf perf;
+
+	me = knode_get_num() - PROCESSOR_NODENUM_LEADER;
+
+	/* Registered names, from the oldest to the newest. */
+	for (int i = 0; i < NPROBES; i++)
+	{
+		build_name(name, me, (i*nlinked)/NPROBES);
+
+		benchmark_perf_start(&perf);
+		uassert(name_lookup(name) == knode_get_num());
+		benchmark_perf_stop(&perf);
+		lookup_latencies[i] = benchmark_perf_cycles(&perf);
+	}
+
+	mean = stats_mean(lookup_latencies, NPROBES);
+	dump_latencies("lookup", occupancy, lookup_latencies, NPROBES);
+
+	/* Missing names. */
+	for (int i = 0; i < NPROBES; i++)
+	{
+		usprintf(name, "churn-miss-%d-%d", me, i);
+
+		benchmark_perf_start(&perf);
+		uassert(name_lookup(name) < 0);
+		benchmark_perf_stop(&perf);
+		lookup_latencies[i] = benchmark_perf_cycles(&perf);
+	}
+
+	dump_latencies("miss", occupancy, lookup_latencies, NPROBES);
+
+	return (mean);
+}
+
+/**
+ * @brief Fits lookup latency to table occupancy.
+ *
+ * @param nbatches Number of batches.
+ */
+static void dump_lookup_slope(int nbatches)
+{
+	double n, x, y;
+	double sx, sy, sxx, sxy;
+	double slope, intercept;
+
+	/* Not enough samples. */
+	if (nbatches < 2)
+		return;
+
+	n = sx = sy = sxx = sxy = 0.0;
+	for (int i = 0; i < nbatches; i++)
+	{
+		x = (double) ((i + 1)*BATCH_SIZE*NANVIX_PROC_MAX);
+		y = (double) lookup_means[i];
+
+		n += 1.0;
+		sx += x;
+		sy += y;
+		sxx += x*x;
+		sxy += x*y;
+	}
+
+	slope = (n*sxy - sx*sy)/(n*sxx - sx*sx);
+	intercept = (sy - slope*sx)/n;
+
+	benchmark_record_signed("nameserver", "churn-model", 0, "base", (int64_t) intercept, BENCHMARK_UNIT_CYCLES);
+
+	/* Slope is reported per 1024 names, rounded to nearest. */
+	slope *= 1024.0;
+	slope += (slope < 0.0) ? -0.5 : 0.5;
+
+	benchmark_record_signed("nameserver", "churn-model", 0, "slope", (int64_t) slope, BENCHMARK_UNIT_CYCLESKN);
+}
+
+/**
+ * @brief Benchmarks registration and unregistration of names.
+ *
+ * Every node registers names in batches, and lookup latency is
+ * measured after each batch, so that the effect of table occupancy on
+ * lookups may be observed. Then, all names are unregistered.
+ */
+static void benchmark_nameserver_churn(void)
+{
+	int me;
+	int nlinked;
+	int occupancy;
+	char name[NANVIX_PROC_NAME_MAX];
+	struct benchmark_perf perf;
+
+	me = knode_get_num() - PROCESSOR_NODENUM_LEADER;
+
+	/* Build list of nodes. */
+	for (int i = 0; i < NANVIX_PROC_MAX; i++)
+		nodes[i] = PROCESSOR_NODENUM_LEADER + i;
+
+	barrier = barrier_create(nodes, NANVIX_PROC_MAX);
+	uassert(BARRIER_IS_VALID(barrier));
+
+	/* Register names. */
+	nlinked = 0;
+	for (int b = 0; b < NBATCHES; b++)
+	{
+		uassert(barrier_wait(barrier) == 0);
+
+		for (int k = b*BATCH_SIZE; (k < (b + 1)*BATCH_SIZE) && (k < NAMES_PER_NODE); k++)
+		{
+			build_name(name, me, k);
+
+			benchmark_perf_start(&perf);
+			uassert(name_link(knode_get_num(), name) == 0);
+			benchmark_perf_stop(&perf);
+			link_latencies[k] = benchmark_perf_cycles(&perf);
+
+			nlinked++;
+		}
+
+		uassert(barrier_wait(barrier) == 0);
+
+		occupancy = nlinked*NANVIX_PROC_MAX;
+		lookup_means[b] = probe_lookups(occupancy, nlinked);
+	}
+
+	dump_latencies("link", occupancy, link_latencies, nlinked);
+
+	if (me == 0)
+		dump_lookup_slope(NBATCHES);
+
+	uassert(barrier_wait(barrier) == 0);
+
+	/* Unregister names. */
+	for (int k = 0; k < nlinked; k++)
+	{
+		build_name(name, me, k);
+
+		benchmark_perf_start(&perf);
+		uassert(name_unlink(name) == 0);
+		benchmark_perf_stop(&perf);
+		unlink_latencies[k] = benchmark_perf_cycles(&perf);
+	}
+
+	uassert(barrier_wait(barrier) == 0);
+
+	dump_latencies("unlink", 0, unlink_latencies, nlinked);
+
+	uassert(barrier_destroy(barrier) == 0);
+}
+
+/*============================================================================*
+ * Benchmark Driver                                                           *
+ *============================================================================*/
+
+/**
+ * @brief Launches a benchmark.
+ */
+int __main3(int argc, const char *argv[])
+{
+	((void) argc);
+	((void) argv);
+
+	benchmark_calibrate();
+
+	benchmark_nameserver_churn();
+
+	return (0);
+}
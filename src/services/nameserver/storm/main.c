@@ -0,0 +1,242 @@
+/*
+ * MIT License
+ *
+ * Copyright(c) 2011-2020 The Maintainers of Nanvix
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <nanvix/runtime/runtime.h>
+#include <nanvix/runtime/barrier.h>
+#include <nanvix/sys/perf.h>
+#include <nanvix/limits.h>
+#include <nanvix/ulib.h>
+#include <nanvix/pm.h>
+#include <benchmark/stats.h>
+#include <benchmark/record.h>
+#include <benchmark/units.h>
+#include <benchmark/perf.h>
+#include <benchmark/calibration.h>
+
+/**
+ * @brief Period of heartbeats (in cycles).
+ */
+#ifndef HEARTBEAT_PERIOD
+#define HEARTBEAT_PERIOD (BENCHMARK_TIMER_FREQ/1000)
+#endif
+
+/**
+ * @brief Duration of the storm (in cycles).
+ */
+#ifndef STORM_DURATION
+#ifdef NDEBUG
+#define STORM_DURATION (2*BENCHMARK_TIMER_FREQ)
+#else
+#define STORM_DURATION (BENCHMARK_TIMER_FREQ/10)
+#endif
+#endif
+
+/**
+ * @brief Number of lookups issued by the client.
+ */
+#ifdef NDEBUG
+#define NLOOKUPS 256
+#else
+#define NLOOKUPS 16
+#endif
+
+/**
+ * @brief Number of heartbeats sent by each node.
+ */
+#define NHEARTBEATS ((int) ((STORM_DURATION + HEARTBEAT_PERIOD - 1)/HEARTBEAT_PERIOD))
+
+/**
+ * @brief Number of samples kept by each node.
+ *
+ * Every operation of a run is kept, so that percentiles cover the whole
+ * storm rather than its tail.
+ */
+#define STORM_SAMPLES ((NHEARTBEATS > NLOOKUPS) ? NHEARTBEATS : NLOOKUPS)
+
+static barrier_t barrier;
+static int nodes[NANVIX_PROC_MAX];
+
+/*============================================================================*
+ * Benchmark Kernel                                                           *
+ *============================================================================*/
+
+/**
+ * @brief Latencies of operations.
+ */
+static uint64_t latencies[STORM_SAMPLES];
+
+/**
+ * @brief Waits until a given time.
+ *
+ * @param deadline Target time.
+ */
+static void wait_until(uint64_t deadline)
+{
+	uint64_t now;
+
+	do
+		kclock(&now);
+	while (now < deadline);
+}
+
+/**
+ * @brief Dumps percentiles of latencies.
+ *
+ * @param op Name of the operation.
+ * @param n  Number of latencies.
+ */
+static void dump_latencies(const char *op, int n)
+{
+	char variant[BENCHMARK_VARIANT_MAX];
+
+	usprintf(variant, "storm:op=%s", op);
+	benchmark_record("nameserver", variant, 0, "n", n, BENCHMARK_UNIT_COUNT);
+
+	stats_sort(latencies, n);
+
+	benchmark_record_time("nameserver", variant, 0, "p50", stats_percentile(latencies, n, 50));
+	benchmark_record_time("nameserver", variant, 0, "p90", stats_percentile(latencies, n, 90));
+	benchmark_record_time("nameserver", variant, 0, "p99", stats_percentile(latencies, n, 99));
+	benchmark_record_time("nameserver", variant, 0, "max", stats_percentile(latencies, n, 100));
+}
+
+/**
+ * @brief Issues lookups at a fixed rate for a given duration.
+ *
+ * @param op       Name of the run.
+ * @param duration Duration of the run (in cycles).
+ */
+static void do_client(const char *op, uint64_t duration)
+{
+	int nodenum;
+	const char *pname;
+	uint64_t t0;
+	struct benchmark_perf perf;
+
+	nodenum = knode_get_num();
+	pname = nanvix_getpname();
+
+	kclock(&t0);
+	for (int i = 0; i < NLOOKUPS; i++)
+	{
+		wait_until(t0 + (i*duration)/NLOOKUPS);
+
+		benchmark_perf_start(&perf);
+		uassert(name_lookup(pname) == nodenum);
+		benchmark_perf_stop(&perf);
+		latencies[i] = benchmark_perf_cycles(&perf);
+	}
+
+	dump_latencies(op, NLOOKUPS);
+}
+
+/**
+ * @brief Sends heartbeats periodically for a given duration.
+ *
+ * @param duration Duration of the storm (in cycles).
+ */
+static void do_heartbeats(uint64_t duration)
+{
+	int n;
+	int overruns;
+	uint64_t t0, next;
+	uint64_t latency;
+	struct benchmark_perf perf;
+
+	n = 0;
+	overruns = 0;
+	kclock(&t0);
+	for (next = t0; next < (t0 + duration); next += HEARTBEAT_PERIOD)
+	{
+		wait_until(next);
+
+		benchmark_perf_start(&perf);
+		uassert(name_heartbeat() == 0);
+		benchmark_perf_stop(&perf);
+		latency = benchmark_perf_cycles(&perf);
+
+		uassert(n < STORM_SAMPLES);
+		latencies[n++] = latency;
+
+		/* Missed next deadline. */
+		if (latency > HEARTBEAT_PERIOD)
+			overruns++;
+	}
+
+	dump_latencies("heartbeat", n);
+	benchmark_record("nameserver", "storm:op=heartbeat", 0, "overruns", overruns, BENCHMARK_UNIT_COUNT);
+}
+
+/**
+ * @brief Benchmarks heartbeats from every node.
+ *
+ * All nodes but the leader send heartbeats at a fixed period, for a
+ * sustained duration. Meanwhile, the leader issues lookups, so that the
+ * lookup latency observed during the storm may be compared to the one
+ * observed in an idle system. Heartbeat latency percentiles and the
+ * number of heartbeats that took longer than the period are reported.
+ */
+static void benchmark_nameserver_storm(void)
+{
+	/* Build list of nodes. */
+	for (int i = 0; i < NANVIX_PROC_MAX; i++)
+		nodes[i] = PROCESSOR_NODENUM_LEADER + i;
+
+	barrier = barrier_create(nodes, NANVIX_PROC_MAX);
+	uassert(BARRIER_IS_VALID(barrier));
+
+	/* Idle system. */
+	uassert(barrier_wait(barrier) == 0);
+	if (knode_get_num() == PROCESSOR_NODENUM_LEADER)
+		do_client("idle", STORM_DURATION);
+
+	/* Storm. */
+	uassert(barrier_wait(barrier) == 0);
+	if (knode_get_num() == PROCESSOR_NODENUM_LEADER)
+		do_client("lookup", STORM_DURATION);
+	else
+		do_heartbeats(STORM_DURATION);
+
+	uassert(barrier_wait(barrier) == 0);
+	uassert(barrier_destroy(barrier) == 0);
+}
+
+/*============================================================================*
+ * Benchmark Driver                                                           *
+ *============================================================================*/
+
+/**
+ * @brief Launches a benchmark.
+ */
+int __main3(int argc, const char *argv[])
+{
+	((void) argc);
+	((void) argv);
+
+	benchmark_calibrate();
+
+	benchmark_nameserver_storm();
+
+	return (0);
+}
@@ -0,0 +1,262 @@
+/*
+ * MIT License
+ *
+ * Copyright(c) 2011-2020 The Maintainers of Nanvix
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <nanvix/runtime/runtime.h>
+#include <nanvix/runtime/barrier.h>
+#include <nanvix/sys/perf.h>
+#include <nanvix/limits.h>
+#include <nanvix/ulib.h>
+#include <benchmark/stats.h>
+#include <benchmark/record.h>
+#include <benchmark/units.h>
+#include <benchmark/perf.h>
+#include <benchmark/calibration.h>
+
+/**
+ * @brief Number of lookups issued by each client in a run.
+ */
+#ifdef NDEBUG
+#define NLOOKUPS 100
+#else
+#define NLOOKUPS 10
+#endif
+
+/**
+ * @brief Number of names registered by each node.
+ */
+#ifndef NAMES_PER_NODE
+#define NAMES_PER_NODE 2
+#endif
+
+static barrier_t barrier;
+static int nodes[NANVIX_PROC_MAX];
+
+/*============================================================================*
+ * Benchmark Kernel                                                           *
+ *============================================================================*/
+
+/**
+ * @name Kinds of Lookups
+ */
+/**@{*/
+#define LOOKUP_OWN     0 /**< Own names.            */
+#define LOOKUP_OTHER   1 /**< Other clusters' names. */
+#define LOOKUP_MISSING 2 /**< Missing names.        */
+#define LOOKUP_KINDS   3 /**< Number of kinds.      */
+/**@}*/
+
+/**
+ * @brief Names of kinds of lookups.
+ */
+static const char *lookup_kinds[LOOKUP_KINDS] = {
+	"own", "other", "missing"
+};
+
+/**
+ * @brief Lookup latencies.
+ */
+static uint64_t latencies[NLOOKUPS];
+
+/**
+ * @brief Builds the name of a registered name.
+ *
+ * @param name Store location for the name.
+ * @param idx  Index of the owner node.
+ * @param k    Index of the name in the owner node.
+ */
+static void build_name(char *name, int idx, int k)
+{
+	usprintf(name, "tput-%d-%d", idx, k);
+}
+
+/**
+ * @brief Issues lookups in a tight loop.
+ *
+ * @param kind Kind of lookups.
+ */
+static void do_client(int kind)
+{
+	int me;
+	int peer;
+	int expected;
+	char name[NANVIX_PROC_NAME_MAX];
+	struct benchmark_perf perf;
+
+	me = knode_get_num() - PROCESSOR_NODENUM_LEADER;
+
+	for (int i = 0; i < NLOOKUPS; i++)
+	{
+		switch (kind)
+		{
+			case LOOKUP_OWN:
+				build_name(name, me, i % NAMES_PER_NODE);
+				expected = knode_get_num();
+				break;
+
+			case LOOKUP_OTHER:
+				peer = (me + 1 + (i % (NANVIX_PROC_MAX - 1))) % NANVIX_PROC_MAX;
+				build_name(name, peer, i % NAMES_PER_NODE);
+				expected = PROCESSOR_NODENUM_LEADER + peer;
+				break;
+
+			default:
+				usprintf(name, "miss-%d-%d", me, i);
+				expected = -1;
+				break;
+		}
+
+		benchmark_perf_start(&perf);
+		if (expected >= 0)
+			uassert(name_lookup(name) == expected);
+		else
+			uassert(name_lookup(name) < 0);
+		benchmark_perf_stop(&perf);
+		latencies[i] = benchmark_perf_cycles(&perf);
+	}
+}
+
+/**
+ * @brief Runs lookups with a given number of clients.
+ *
+ * @param kind     Kind of lookups.
+ * @param nclients Number of clients.
+ */
+static void benchmark_lookups(int kind, int nclients)
+{
+	int me;
+	uint64_t t0, t1, elapsed;
+	char variant[BENCHMARK_VARIANT_MAX];
+
+	me = knode_get_num() - PROCESSOR_NODENUM_LEADER;
+
+	uassert(barrier_wait(barrier) == 0);
+	kclock(&t0);
+
+		if (me < nclients)
+			do_client(kind);
+
+	uassert(barrier_wait(barrier) == 0);
+	kclock(&t1);
+	elapsed = benchmark_elapsed(t0, t1);
+
+	usprintf(variant, "throughput:kind=%s,clients=%d", lookup_kinds[kind], nclients);
+
+	/* Per-client latencies. */
+	if (me < nclients)
+	{
+		stats_sort(latencies, NLOOKUPS);
+
+		benchmark_record_time("nameserver", variant, 0, "p50", stats_percentile(latencies, NLOOKUPS, 50));
+		benchmark_record_time("nameserver", variant, 0, "p90", stats_percentile(latencies, NLOOKUPS, 90));
+		benchmark_record_time("nameserver", variant, 0, "p99", stats_percentile(latencies, NLOOKUPS, 99));
+	}
+
+	/* Aggregate throughput. */
+	if ((me == 0) && (elapsed > 0))
+	{
+		benchmark_record("nameserver", variant, 0, "throughput",
+			(((uint64_t) nclients)*NLOOKUPS*BENCHMARK_TIMER_FREQ)/elapsed,
+			BENCHMARK_UNIT_OPS
+		);
+	}
+}
+
+/**
+ * @brief Benchmarks name-service throughput.
+ *
+ * Every node registers some names and then clients issue lookups in a
+ * tight loop for their own names, other nodes' names and missing names.
+ * The number of clients is doubled at each run, so that saturation of
+ * the name server may be observed.
+ */
+static void benchmark_nameserver_throughput(void)
+{
+	int me;
+	char name[NANVIX_PROC_NAME_MAX];
+
+	me = knode_get_num() - PROCESSOR_NODENUM_LEADER;
+
+	/* Build list of nodes. */
+	for (int i = 0; i < NANVIX_PROC_MAX; i++)
+		nodes[i] = PROCESSOR_NODENUM_LEADER + i;
+
+	barrier = barrier_create(nodes, NANVIX_PROC_MAX);
+	uassert(BARRIER_IS_VALID(barrier));
+
+	/* Register names. */
+	for (int k = 0; k < NAMES_PER_NODE; k++)
+	{
+		build_name(name, me, k);
+		uassert(name_link(knode_get_num(), name) == 0);
+	}
+
+	/* Warmup. */
+	build_name(name, me, 0);
+	uassert(name_lookup(name) == knode_get_num());
+
+	for (int kind = 0; kind < LOOKUP_KINDS; kind++)
+	{
+		for (int nclients = 1; ; nclients *= 2)
+		{
+			if (nclients > NANVIX_PROC_MAX)
+				nclients = NANVIX_PROC_MAX;
+
+			benchmark_lookups(kind, nclients);
+
+			if (nclients == NANVIX_PROC_MAX)
+				break;
+		}
+	}
+
+	uassert(barrier_wait(barrier) == 0);
+
+	/* Unregister names. */
+	for (int k = 0; k < NAMES_PER_NODE; k++)
+	{
+		build_name(name, me, k);
+		uassert(name_unlink(name) == 0);
+	}
+
+	uassert(barrier_wait(barrier) == 0);
+	uassert(barrier_destroy(barrier) == 0);
+}
+
+/*============================================================================*
+ * Benchmark Driver                                                           *
+ *============================================================================*/
+
+/**
+ * @brief Launches a benchmark.
+ */
+int __main3(int argc, const char *argv[])
+{
+	((void) argc);
+	((void) argv);
+
+	benchmark_calibrate();
+
+	benchmark_nameserver_throughput();
+
+	return (0);
+}
@@ -25,6 +25,9 @@
 #include <nanvix/runtime/runtime.h>
 #include <nanvix/sys/perf.h>
 #include <nanvix/ulib.h>
+#include <benchmark/record.h>
+#include <benchmark/perf.h>
+#include <benchmark/calibration.h>
 
 /*============================================================================*
  * Benchmark                                                                  *
@@ -41,26 +44,19 @@ static char buffer[RMEM_BLOCK_SIZE];
 static void benchmark_pgfetch(void)
 {
 	void *ptr;
-	uint64_t time_pgfetch;
+	struct benchmark_perf perf_pgfetch;
 
 		uassert((ptr = nanvix_vmem_alloc(1)) != NULL);
 
-	perf_start(0, PERF_CYCLES);
+	benchmark_perf_start(&perf_pgfetch);
 
 		uassert(nanvix_vmem_read(buffer, ptr, RMEM_BLOCK_SIZE) == RMEM_BLOCK_SIZE);
 
-	perf_stop(0);
-	time_pgfetch = perf_read(0);
+	benchmark_perf_stop(&perf_pgfetch);
 
 	uassert(nanvix_vmem_free(ptr) == 0);
 
-#ifndef NDEBUG
-	uprintf("[benchmarks][pgfetch] %l",
-#else
-	uprintf("[benchmarks][pgfetch] %l",
-#endif
-		time_pgfetch
-	);
+	benchmark_perf_record("pgfetch", "single", 0, "time", &perf_pgfetch, RMEM_BLOCK_SIZE);
 }
 
 /*============================================================================*
@@ -75,6 +71,8 @@ int __main3(int argc, const char *argv[])
 	((void) argc);
 	((void) argv);
 
+	benchmark_calibrate();
+
 	benchmark_pgfetch();
 
 	return (0);
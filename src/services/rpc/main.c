@@ -0,0 +1,335 @@
+/*
+ * MIT License
+ *
+ * Copyright(c) 2011-2020 The Maintainers of Nanvix
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <nanvix/servers/message.h>
+#include <nanvix/runtime/runtime.h>
+#include <nanvix/runtime/barrier.h>
+#include <nanvix/sys/perf.h>
+#include <nanvix/limits.h>
+#include <nanvix/ulib.h>
+#include <benchmark/record.h>
+#include <benchmark/units.h>
+#include <benchmark/stats.h>
+#include <benchmark/calibration.h>
+
+/**
+ * @brief Number of iterations for the benchmark.
+ */
+#ifdef NDEBUG
+#define NITERATIONS 30
+#else
+#define NITERATIONS 1
+#endif
+
+static barrier_t barrier;
+static int nodes[NANVIX_PROC_MAX];
+
+/*============================================================================*
+ * RPC Server                                                                 *
+ *============================================================================*/
+
+/**
+ * @brief Port number of standard input mailboxes.
+ */
+#define STDINBOX_PORT 1
+
+/**
+ * @brief Number of requests issued by each client.
+ */
+#ifndef NREQUESTS
+#define NREQUESTS 256
+#endif
+
+/**
+ * @brief Longest interval between requests of a client (in cycles).
+ */
+#ifndef INTERVAL_MAX
+#define INTERVAL_MAX (1 << 20)
+#endif
+
+/**
+ * @brief Shortest interval between requests of a client (in cycles).
+ */
+#ifndef INTERVAL_MIN
+#define INTERVAL_MIN (1 << 10)
+#endif
+
+/**
+ * @brief Maximum number of outstanding requests of a client.
+ *
+ * Clients drain replies before exceeding this window, so that the
+ * server never blocks on a full client mailbox.
+ */
+#ifndef RPC_WINDOW
+#define RPC_WINDOW 4
+#endif
+
+/**
+ * @name Operation codes.
+ */
+/**@{*/
+#define RPC_ECHO  1 /**< Echo request. */
+#define RPC_REPLY 2 /**< Echo reply.   */
+/**@}*/
+
+/**
+ * @brief RPC message.
+ */
+struct message
+{
+	message_header header; /**< Header.                         */
+	int seq;               /**< Sequence number.                */
+	uint64_t stamp;        /**< Scheduled time of the request.  */
+};
+
+/**
+ * @brief Latencies of requests.
+ */
+static uint64_t latencies[NREQUESTS];
+
+/**
+ * @brief Mailboxes to peers.
+ */
+static int outboxes[NANVIX_PROC_MAX];
+
+/**
+ * @brief Serves echo requests.
+ *
+ * @param nrequests Number of requests to serve.
+ *
+ * @returns The number of cycles spent serving requests.
+ */
+static uint64_t rpc_serve(int nrequests)
+{
+	int client;
+	uint64_t t0, t1;
+	uint64_t busy = 0;
+	struct message msg;
+
+	for (int i = 0; i < nrequests; i++)
+	{
+		uassert(kmailbox_read(
+			stdinbox_get(), &msg, sizeof(struct message)
+		) == sizeof(struct message));
+
+		kclock(&t0);
+
+			uassert(msg.header.opcode == RPC_ECHO);
+
+			client = msg.header.source - PROCESSOR_NODENUM_LEADER;
+			msg.header.source = knode_get_num();
+			msg.header.opcode = RPC_REPLY;
+
+			uassert(kmailbox_write(
+				outboxes[client], &msg, sizeof(struct message)
+			) == sizeof(struct message));
+
+		kclock(&t1);
+		busy += benchmark_elapsed(t0, t1);
+	}
+
+	return (busy);
+}
+
+/**
+ * @brief Issues open-loop requests.
+ *
+ * Requests are scheduled every @p interval cycles, regardless of
+ * replies, as long as fewer than RPC_WINDOW are outstanding. Latencies
+ * are measured from the scheduled time, so that a late send is charged
+ * to the server rather than hidden.
+ *
+ * @param interval Interval between requests (in cycles).
+ */
+static void rpc_issue(uint64_t interval)
+{
+	int sent = 0;
+	int received = 0;
+	uint64_t start, now, due;
+	struct message msg;
+
+	kclock(&start);
+
+	while (received < NREQUESTS)
+	{
+		due = start + sent*interval;
+		kclock(&now);
+
+		/* Send a request. */
+		if ((sent < NREQUESTS) && ((sent - received) < RPC_WINDOW) &&
+			((now >= due) || (sent == received)))
+		{
+			while (now < due)
+				kclock(&now);
+
+			msg.header.source = knode_get_num();
+			msg.header.opcode = RPC_ECHO;
+			msg.seq = sent++;
+			msg.stamp = due;
+
+			uassert(kmailbox_write(
+				outboxes[0], &msg, sizeof(struct message)
+			) == sizeof(struct message));
+		}
+
+		/* Collect a reply. */
+		else
+		{
+			uassert(kmailbox_read(
+				stdinbox_get(), &msg, sizeof(struct message)
+			) == sizeof(struct message));
+			kclock(&now);
+
+			uassert(msg.header.opcode == RPC_REPLY);
+			uassert(msg.seq == received);
+
+			latencies[received++] = benchmark_elapsed(msg.stamp, now);
+		}
+	}
+}
+
+/*============================================================================*
+ * Benchmark                                                                  *
+ *============================================================================*/
+
+/**
+ * @brief Benchmarks an RPC server under a given load.
+ *
+ * @param interval Interval between requests of a client (in cycles).
+ */
+static void benchmark_rpc(uint64_t interval)
+{
+	int me;
+	int nclients;
+	uint64_t t0, t1, elapsed;
+	uint64_t busy = 0;
+	char variant[BENCHMARK_VARIANT_MAX];
+
+	me = knode_get_num() - PROCESSOR_NODENUM_LEADER;
+	nclients = NANVIX_PROC_MAX - 1;
+
+	usprintf(variant, "rpc:clients=%d,interval=%l", nclients, interval);
+
+	for (int i = 1; i <= NITERATIONS; i++)
+	{
+		uassert(barrier_wait(barrier) == 0);
+		kclock(&t0);
+
+			if (me == 0)
+				busy = rpc_serve(nclients*NREQUESTS);
+			else
+				rpc_issue(interval);
+
+		uassert(barrier_wait(barrier) == 0);
+		kclock(&t1);
+		elapsed = benchmark_elapsed(t0, t1);
+
+		/* Dump statistics. */
+		if (me == 0)
+		{
+			benchmark_record("rpc", variant, i, "offered",
+				((uint64_t) nclients*BENCHMARK_TIMER_FREQ)/interval,
+				BENCHMARK_UNIT_OPS
+			);
+			if (elapsed > 0)
+			{
+				benchmark_record("rpc", variant, i, "throughput",
+					((uint64_t) nclients*NREQUESTS*BENCHMARK_TIMER_FREQ)/elapsed,
+					BENCHMARK_UNIT_OPS
+				);
+				benchmark_record("rpc", variant, i, "utilization", (busy*1000)/elapsed, BENCHMARK_UNIT_MILLI);
+			}
+		}
+		else
+		{
+			stats_sort(latencies, NREQUESTS);
+			benchmark_record_time("rpc", variant, i, "p50", stats_percentile(latencies, NREQUESTS, 50));
+			benchmark_record_time("rpc", variant, i, "p90", stats_percentile(latencies, NREQUESTS, 90));
+			benchmark_record_time("rpc", variant, i, "p99", stats_percentile(latencies, NREQUESTS, 99));
+			benchmark_record_time("rpc", variant, i, "max", latencies[NREQUESTS - 1]);
+		}
+	}
+}
+
+/**
+ * @brief Benchmarks the capacity of a single-cluster server.
+ */
+static void benchmark_services_rpc(void)
+{
+	int me;
+
+	me = knode_get_num() - PROCESSOR_NODENUM_LEADER;
+
+	/* Build list of nodes. */
+	for (int i = 0; i < NANVIX_PROC_MAX; i++)
+		nodes[i] = PROCESSOR_NODENUM_LEADER + i;
+
+	barrier = barrier_create(nodes, NANVIX_PROC_MAX);
+	uassert(BARRIER_IS_VALID(barrier));
+
+	/* Server talks to all clients, clients talk to the server. */
+	if (me == 0)
+	{
+		for (int i = 1; i < NANVIX_PROC_MAX; i++)
+			uassert((outboxes[i] = kmailbox_open(nodes[i], STDINBOX_PORT)) >= 0);
+	}
+	else
+		uassert((outboxes[0] = kmailbox_open(nodes[0], STDINBOX_PORT)) >= 0);
+
+	uassert(barrier_wait(barrier) == 0);
+
+		/* Raise the load up to saturation. */
+		for (uint64_t interval = INTERVAL_MAX; interval >= INTERVAL_MIN; interval /= 2)
+			benchmark_rpc(interval);
+
+	/* House keeping. */
+	if (me == 0)
+	{
+		for (int i = 1; i < NANVIX_PROC_MAX; i++)
+			uassert(kmailbox_close(outboxes[i]) == 0);
+	}
+	else
+		uassert(kmailbox_close(outboxes[0]) == 0);
+
+	uassert(barrier_destroy(barrier) == 0);
+}
+
+/*============================================================================*
+ * Benchmark Driver                                                           *
+ *============================================================================*/
+
+/**
+ * @brief Launches a benchmark.
+ */
+int __main3(int argc, const char *argv[])
+{
+	((void) argc);
+	((void) argv);
+
+	benchmark_calibrate();
+
+	benchmark_services_rpc();
+
+	return (0);
+}
@@ -0,0 +1,269 @@
+/*
+ * MIT License
+ *
+ * Copyright(c) 2011-2020 The Maintainers of Nanvix
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <nanvix/runtime/runtime.h>
+#include <nanvix/runtime/barrier.h>
+#include <nanvix/sys/perf.h>
+#include <nanvix/limits.h>
+#include <nanvix/ulib.h>
+#include <benchmark/record.h>
+#include <benchmark/units.h>
+#include <benchmark/stats.h>
+#include <benchmark/calibration.h>
+
+/**
+ * @brief Number of iterations for the benchmark.
+ */
+#ifdef NDEBUG
+#define NITERATIONS 30
+#else
+#define NITERATIONS 1
+#endif
+
+static barrier_t barrier;
+static int nodes[NANVIX_PROC_MAX];
+
+/*============================================================================*
+ * Benchmark                                                                  *
+ *============================================================================*/
+
+/**
+ * @brief Does the clock of a cluster start with its kernel?
+ *
+ * Compute clusters of the MPPA-256 are booted from reset, so their clocks
+ * count from kernel start. On unix64, clusters are processes that read
+ * the clock of the host, so clock values are not relative to boot and
+ * startup times are not reported.
+ */
+#ifndef BOOT_CLOCK
+#if defined(__mppa256__)
+#define BOOT_CLOCK 1
+#else
+#define BOOT_CLOCK 0
+#endif
+#endif
+
+/**
+ * @brief Port number used to replay runtime setup.
+ */
+#define REPLAY_PORT 10
+
+/**
+ * @brief Port number used to gather timestamps.
+ */
+#define GATHER_PORT 11
+
+/**
+ * @name Steps of runtime setup and teardown.
+ */
+/**@{*/
+#define STEP_MAILBOX 0 /**< Standard mailbox.  */
+#define STEP_PORTAL  1 /**< Standard portal.   */
+#define STEP_NAME    2 /**< Name registration. */
+#define STEP_NUM     3 /**< Number of steps.   */
+/**@}*/
+
+/**
+ * @brief Names of steps.
+ */
+static const char *steps[STEP_NUM] = { "mailbox", "portal", "name" };
+
+/**
+ * @brief Clock value at entry of __main3().
+ *
+ * Where BOOT_CLOCK holds, this is the time from kernel start to the
+ * entry point of the benchmark.
+ */
+static uint64_t main3_stamp;
+
+#if (BOOT_CLOCK)
+
+/**
+ * @brief Startup times of all clusters (leader only).
+ */
+static uint64_t startups[NANVIX_PROC_MAX];
+
+/**
+ * @brief Gathers startup times at the leader and dumps their distribution.
+ */
+static void benchmark_startup_distribution(void)
+{
+	int inbox, outbox;
+	uint64_t msg[KMAILBOX_MESSAGE_SIZE/sizeof(uint64_t)];
+
+	if (knode_get_num() == PROCESSOR_NODENUM_LEADER)
+	{
+		uassert((inbox = kmailbox_create(knode_get_num(), GATHER_PORT)) >= 0);
+
+		uassert(barrier_wait(barrier) == 0);
+
+		startups[0] = main3_stamp;
+		for (int i = 1; i < NANVIX_PROC_MAX; i++)
+		{
+			uassert(kmailbox_read(inbox, msg, KMAILBOX_MESSAGE_SIZE) == KMAILBOX_MESSAGE_SIZE);
+			startups[i] = msg[0];
+		}
+
+		uassert(kmailbox_unlink(inbox) == 0);
+
+		stats_sort(startups, NANVIX_PROC_MAX);
+		benchmark_record_time("startup", "boot-to-main", 0, "min", startups[0]);
+		benchmark_record_time("startup", "boot-to-main", 0, "p50", stats_percentile(startups, NANVIX_PROC_MAX, 50));
+		benchmark_record_time("startup", "boot-to-main", 0, "mean", stats_mean(startups, NANVIX_PROC_MAX));
+		benchmark_record_time("startup", "boot-to-main", 0, "max", startups[NANVIX_PROC_MAX - 1]);
+	}
+	else
+	{
+		uassert(barrier_wait(barrier) == 0);
+
+		umemset(msg, 0, sizeof(msg));
+		msg[0] = main3_stamp;
+
+		uassert((outbox = kmailbox_open(PROCESSOR_NODENUM_LEADER, GATHER_PORT)) >= 0);
+		uassert(kmailbox_write(outbox, msg, KMAILBOX_MESSAGE_SIZE) == KMAILBOX_MESSAGE_SIZE);
+		uassert(kmailbox_close(outbox) == 0);
+	}
+}
+
+#endif /* BOOT_CLOCK */
+
+/**
+ * @brief Approximates runtime setup and teardown.
+ *
+ * The runtime is already up when __main3() runs, so its setup steps are
+ * replayed on spare ports and under a spare name: a mailbox and a portal
+ * like the standard ones, and a name registration like the one of the
+ * process. Teardown undoes them in reverse order. Records are named
+ * "approx-*", as they do not time the runtime itself.
+ */
+static void benchmark_startup_replay(void)
+{
+	int mailbox, portal;
+	uint64_t t0, t1;
+	uint64_t setup[STEP_NUM], teardown[STEP_NUM];
+	uint64_t total_setup, total_teardown;
+	char name[NANVIX_PROC_NAME_MAX];
+	char metric[BENCHMARK_VARIANT_MAX];
+
+	usprintf(name, "startup-%d", knode_get_num());
+
+	for (int i = 1; i <= NITERATIONS; i++)
+	{
+		uassert(barrier_wait(barrier) == 0);
+
+		/* Setup. */
+		kclock(&t0);
+			uassert((mailbox = kmailbox_create(knode_get_num(), REPLAY_PORT)) >= 0);
+		kclock(&t1);
+		setup[STEP_MAILBOX] = benchmark_elapsed(t0, t1);
+
+		kclock(&t0);
+			uassert((portal = kportal_create(knode_get_num(), REPLAY_PORT)) >= 0);
+		kclock(&t1);
+		setup[STEP_PORTAL] = benchmark_elapsed(t0, t1);
+
+		kclock(&t0);
+			uassert(name_link(knode_get_num(), name) == 0);
+		kclock(&t1);
+		setup[STEP_NAME] = benchmark_elapsed(t0, t1);
+
+		uassert(barrier_wait(barrier) == 0);
+
+		/* Teardown. */
+		kclock(&t0);
+			uassert(name_unlink(name) == 0);
+		kclock(&t1);
+		teardown[STEP_NAME] = benchmark_elapsed(t0, t1);
+
+		kclock(&t0);
+			uassert(kportal_unlink(portal) == 0);
+		kclock(&t1);
+		teardown[STEP_PORTAL] = benchmark_elapsed(t0, t1);
+
+		kclock(&t0);
+			uassert(kmailbox_unlink(mailbox) == 0);
+		kclock(&t1);
+		teardown[STEP_MAILBOX] = benchmark_elapsed(t0, t1);
+
+		/* Dump statistics. */
+		total_setup = total_teardown = 0;
+		for (int j = 0; j < STEP_NUM; j++)
+		{
+			usprintf(metric, "approx-setup.%s", steps[j]);
+			benchmark_record_time("startup", "approx-runtime", i, metric, setup[j]);
+			usprintf(metric, "approx-teardown.%s", steps[j]);
+			benchmark_record_time("startup", "approx-runtime", i, metric, teardown[j]);
+
+			total_setup += setup[j];
+			total_teardown += teardown[j];
+		}
+		benchmark_record_time("startup", "approx-runtime", i, "approx-setup", total_setup);
+		benchmark_record_time("startup", "approx-runtime", i, "approx-teardown", total_teardown);
+	}
+}
+
+/**
+ * @brief Benchmarks process startup and teardown.
+ */
+static void benchmark_startup(void)
+{
+	/* Build list of nodes. */
+	for (int i = 0; i < NANVIX_PROC_MAX; i++)
+		nodes[i] = PROCESSOR_NODENUM_LEADER + i;
+
+#if (BOOT_CLOCK)
+	benchmark_record_time("startup", "boot-to-main", 0, "time", main3_stamp);
+#endif
+
+	barrier = barrier_create(nodes, NANVIX_PROC_MAX);
+	uassert(BARRIER_IS_VALID(barrier));
+
+#if (BOOT_CLOCK)
+		benchmark_startup_distribution();
+#endif
+		benchmark_startup_replay();
+
+	uassert(barrier_destroy(barrier) == 0);
+}
+
+/*============================================================================*
+ * Benchmark Driver                                                           *
+ *============================================================================*/
+
+/**
+ * @brief Launches a benchmark.
+ */
+int __main3(int argc, const char *argv[])
+{
+	kclock(&main3_stamp);
+
+	((void) argc);
+	((void) argv);
+
+	benchmark_calibrate();
+
+	benchmark_startup();
+
+	return (0);
+}